@@ -0,0 +1,20 @@
+#pragma once
+
+// Checks for the host-side tests. A failed check is reported and counted, and Finish turns the count into the exit
+// code ctest looks at.
+namespace Test {
+
+    inline int n_failed = 0;
+
+    inline void Check(const bool a_ok, const std::string_view a_what) {
+        if (a_ok) return;
+        std::fprintf(stderr, "FAILED: %.*s\n", static_cast<int>(a_what.size()), a_what.data());
+        n_failed++;
+    }
+
+    inline int Finish() {
+        if (n_failed) return 1;
+        std::puts("ok");
+        return 0;
+    }
+};
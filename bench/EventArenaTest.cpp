@@ -0,0 +1,40 @@
+// EventArena sizing: a buffer grows after an event spills to the heap, stops at max_capacity, and shrinks back once
+// events fit the initial capacity again.
+#include "Check.h"
+#include "EventArena.h"
+
+namespace {
+
+    using Test::Check;
+
+    void Event(const std::size_t a_bytes) {
+        const EventArena::Scope arena_scope;
+        [[maybe_unused]] const auto block = EventArena::Get()->allocate(a_bytes);
+    }
+
+    void GrowAndShrink() {
+        Check(EventArena::Capacity() == EventArena::initial_capacity, "arena starts at the initial capacity");
+        Event(EventArena::initial_capacity / 2);
+        Check(EventArena::Capacity() == EventArena::initial_capacity, "an event that fits leaves the arena alone");
+
+        Event(EventArena::initial_capacity * 4);
+        const auto grown = EventArena::Capacity();
+        Check(grown > EventArena::initial_capacity * 4 && grown <= EventArena::max_capacity, "arena grows to fit");
+        Event(EventArena::max_capacity * 4);
+        Check(EventArena::Capacity() == EventArena::max_capacity, "growth stops at the cap");
+
+        // a large event that fits the grown buffer starts the quiet run over
+        for (unsigned int i = 0; i + 1 < EventArena::quiet_releases; i++) Event(64);
+        Event(EventArena::initial_capacity * 2);
+        for (unsigned int i = 0; i + 1 < EventArena::quiet_releases; i++) Event(64);
+        Check(EventArena::Capacity() == EventArena::max_capacity, "large events keep the grown buffer");
+        Event(64);
+        Check(EventArena::Capacity() == EventArena::initial_capacity, "a run of small events shrinks it back");
+    }
+};
+
+int main() {
+    spdlog::set_level(spdlog::level::off);
+    GrowAndShrink();
+    return Test::Finish();
+}
@@ -0,0 +1,188 @@
+// FavoritesTable on its own: row edits, copies that share blocks and pages, and reuse of released string slots.
+#include <map>
+#include <random>
+#include "Check.h"
+#include "FavoritesTable.h"
+
+namespace {
+
+    using Test::Check;
+
+    // What the table should hold, in FormID order.
+    struct Expected {
+        int hotkey;
+        std::string editorid;
+        std::uint32_t instance;
+    };
+    using Model = std::map<FormID, Expected>;
+
+    bool Matches(const FavoritesTable& a_table, const Model& a_model) {
+        if (a_table.Size() != a_model.size()) return false;
+        std::size_t row = 0;
+        for (const auto& [formid, expected] : a_model) {
+            if (a_table.FormIDAt(row) != formid || a_table.HotkeyAt(row) != expected.hotkey ||
+                a_table.EditorIDAt(row) != expected.editorid || a_table.InstanceAt(row) != expected.instance) {
+                return false;
+            }
+            if (!a_table.Contains(formid) || a_table.GetHotkey(formid) != expected.hotkey ||
+                a_table.GetEditorID(formid) != expected.editorid || a_table.GetInstance(formid) != expected.instance) {
+                return false;
+            }
+            row++;
+        }
+        return true;
+    }
+
+    void InsertEraseRename() {
+        FavoritesTable table;
+        Check(table.Insert(5, 1, "Apple"), "insert");
+        Check(table.Insert(9), "insert without hotkey or editor ID");
+        Check(!table.Insert(5, 2, "Other"), "insert of a FormID already in the table");
+        Check(table.GetHotkey(5) == 1 && table.GetEditorID(5) == "Apple", "first insert kept");
+
+        const std::vector<FavoritesTable::Row> rows{{7, 2, "Cheese"}, {5, 3, "Dup"}, {3, -1, "Apple"}, {7, 4, "Again"}};
+        Check(table.InsertRows(rows) == 2, "batch skips rows already present and repeats");
+        Check(table.FormIDAt(0) == 3 && table.FormIDAt(1) == 5 && table.FormIDAt(2) == 7 && table.FormIDAt(3) == 9,
+              "rows sorted by FormID");
+        Check(table.GetHotkey(7) == 2 && table.GetEditorID(7) == "Cheese", "first row of a repeated FormID wins");
+
+        table.SetEditorID(5, "Pear");
+        table.SetHotkey(5, 20);
+        table.SetInstance(5, 0xABCD);
+        Check(table.GetEditorID(5) == "Pear" && table.GetEditorID(3) == "Apple", "rename touches one row");
+        Check(table.GetHotkey(5) == -1, "out of range hotkey clears it");
+        Check(table.GetInstance(5) == 0xABCD, "instance set");
+
+        Check(table.Erase(7) && !table.Erase(7) && !table.Contains(7), "erase");
+        Check(table.Size() == 3, "size after erase");
+        Check(table.GetEditorID(7).empty() && table.GetHotkey(7) == -1, "missing rows read as empty");
+
+        const auto revision = table.Revision();
+        table.Clear();
+        Check(table.Empty() && table.Revision() > revision, "clear");
+    }
+
+    // Enough rows for several blocks, so a write clones one block and leaves the others shared.
+    void SnapshotIsolation() {
+        FavoritesTable table;
+        Model model;
+        for (FormID formid = 1; formid <= 3000; formid++) {
+            const auto editorid = "Form" + std::to_string(formid % 700);
+            table.Insert(formid, formid % 9 == 0 ? static_cast<int>(formid % 8) : -1, editorid);
+            model[formid] = {formid % 9 == 0 ? static_cast<int>(formid % 8) : -1, editorid, 0};
+        }
+        const FavoritesTable snapshot = table;
+        const auto snapshot_model = model;
+
+        table.SetHotkey(1500, 3);
+        model[1500].hotkey = 3;
+        table.SetEditorID(2999, "Renamed");
+        model[2999].editorid = "Renamed";
+        table.Erase(10);
+        model.erase(10);
+        table.Insert(5000, 1, "New", 7);
+        model[5000] = {1, "New", 7};
+        const std::vector<FavoritesTable::Row> rows{{6000, -1, "Batch"}, {6001, 2, "Form1"}};
+        table.InsertRows(rows);
+        model[6000] = {-1, "Batch", 0};
+        model[6001] = {2, "Form1", 0};
+        Check(Matches(table, model), "writes after a copy land in the table");
+        Check(Matches(snapshot, snapshot_model), "writes after a copy leave the copy alone");
+
+        // and the other way round
+        FavoritesTable copy = table;
+        copy.SetEditorID(1, "OnlyInCopy");
+        copy.Erase(2);
+        Check(Matches(table, model), "writes to a copy leave the original alone");
+        Check(copy.GetEditorID(1) == "OnlyInCopy" && !copy.Contains(2), "writes to a copy land in the copy");
+    }
+
+    void StringSlotReuse() {
+        FavoritesTable table;
+        for (FormID formid = 1; formid <= 600; formid++) table.Insert(formid, -1, "Unique" + std::to_string(formid));
+        const auto slots = table.StringSlots();
+        Check(slots == 601, "one slot per editor ID plus the empty string");
+
+        table.Insert(1000, -1, "Unique1");
+        Check(table.StringSlots() == slots, "equal editor IDs share a slot");
+        for (FormID formid = 1; formid <= 300; formid++) table.Erase(formid);
+        Check(table.GetEditorID(1000) == "Unique1", "a slot still referenced survives its first row");
+        for (FormID formid = 2001; formid <= 2299; formid++) table.Insert(formid, -1, "Other" + std::to_string(formid));
+        Check(table.StringSlots() == slots, "released slots are reused before the pages grow");
+
+        table.SetEditorID(400, "Renamed400");
+        Check(table.StringSlots() == slots, "a rename releases the old editor ID");
+        Check(table.GetEditorID(400) == "Renamed400" && table.GetEditorID(2001) == "Other2001", "reused slots read back");
+
+        // a copy rebuilds its own index and counts before its first write
+        FavoritesTable copy = table;
+        copy.Erase(1000);
+        copy.Insert(3000, -1, "Fresh");
+        Check(copy.GetEditorID(3000) == "Fresh" && table.GetEditorID(1000) == "Unique1", "copies reuse their own slots");
+    }
+
+    // Random edits against a std::map, with copies kept along the way.
+    void AgainstModel() {
+        std::mt19937 rng(1);
+        FavoritesTable table;
+        Model model;
+        std::vector<std::pair<FavoritesTable, Model>> snapshots;
+        for (int step = 0; step < 20000; step++) {
+            const auto formid = static_cast<FormID>(rng() % 3000 + 1);
+            const auto editorid = rng() % 4 ? "Ed" + std::to_string(rng() % 500) : std::string{};
+            const auto raw_hotkey = static_cast<int>(rng() % 17) - 1;
+            const auto hotkey = raw_hotkey < FavoritesTable::no_hotkey ? raw_hotkey : -1;
+            const auto instance = static_cast<std::uint32_t>(rng() % 3);
+            switch (rng() % 8) {
+                case 0:
+                case 1:
+                case 2: {
+                    const bool is_new = model.try_emplace(formid, Expected{hotkey, editorid, instance}).second;
+                    Check(table.Insert(formid, hotkey, editorid, instance) == is_new, "insert reports a new row");
+                    break;
+                }
+                case 3:
+                case 4:
+                    Check(table.Erase(formid) == (model.erase(formid) > 0), "erase reports whether the row was there");
+                    break;
+                case 5:
+                    table.SetEditorID(formid, editorid);
+                    table.SetHotkey(formid, hotkey);
+                    table.SetInstance(formid, instance);
+                    if (const auto it = model.find(formid); it != model.end()) it->second = {hotkey, editorid, instance};
+                    break;
+                case 6: {
+                    std::vector<std::string> names;
+                    std::vector<FavoritesTable::Row> rows;
+                    const auto n_rows = rng() % 600;
+                    names.reserve(n_rows);
+                    std::size_t n_new = 0;
+                    for (std::size_t i = 0; i < n_rows; i++) {
+                        names.push_back("B" + std::to_string(rng() % 700));
+                        rows.push_back({static_cast<FormID>(rng() % 3000 + 1), -1, names.back()});
+                        if (model.try_emplace(rows.back().formid, Expected{-1, names.back(), 0}).second) n_new++;
+                    }
+                    Check(table.InsertRows(rows) == n_new, "batch reports the rows it inserted");
+                    break;
+                }
+                default:
+                    if (rng() % 20) break;
+                    snapshots.emplace_back(table, model);
+                    if (snapshots.size() > 5) snapshots.erase(snapshots.begin());
+            }
+        }
+        Check(Matches(table, model), "random edits match the model");
+        for (const auto& [snapshot, snapshot_model] : snapshots) {
+            Check(Matches(snapshot, snapshot_model), "copies taken along the way are unchanged");
+        }
+    }
+};
+
+int main() {
+    spdlog::set_level(spdlog::level::off);
+    InsertEraseRename();
+    SnapshotIsolation();
+    StringSlotReuse();
+    AgainstModel();
+    return Test::Finish();
+}
@@ -0,0 +1,93 @@
+// Favorites of one stack among several of the same base object, on the stand-in game layer.
+#include "Check.h"
+#include "Events.h"
+#include "World.h"
+
+namespace {
+
+    using Test::Check;
+    using Utils::FunctionsSkyrim::Inventory::GetInstanceFingerprint;
+    using Utils::FunctionsSkyrim::Inventory::SnapshotScope;
+
+    std::unique_ptr<RE::ExtraDataList> Tempered(const float a_health) {
+        auto xList = std::make_unique<RE::ExtraDataList>();
+        auto* xHealth = new RE::ExtraHealth();
+        xHealth->health = a_health;
+        xList->Add(xHealth);
+        return xList;
+    }
+
+    int Hotkey(const RE::ExtraDataList& a_xList) {
+        const auto* xHotkey = a_xList.GetByType<RE::ExtraHotkey>();
+        return xHotkey ? xHotkey->hotkey.underlying() : -2;
+    }
+
+    bool Reconcile(Manager* a_manager) {
+        const EventArena::Scope arena_scope;
+        const SnapshotScope snapshot_scope;
+        return a_manager->AddFavorites();
+    }
+
+    // Two stacks of one sword tempered to different levels; only the better one is a favorite, and it must stay the
+    // favorite when the game drops it and across a save and load.
+    void TwoTemperedStacks() {
+        World world(4, 0);
+        const auto manager = Manager::GetSingleton();
+        const auto sink = myEventSink::GetSingleton();
+        auto* entry = *RE::PlayerCharacter::GetSingleton()->changes.entryList->begin();
+        const auto formid = entry->object->GetFormID();
+
+        // the world favorites a plain stack; move the favorite onto the better of two tempered ones
+        auto* plain = *entry->extraLists->begin();
+        std::erase_if(plain->data, [](auto& d) { return d->GetType() == RE::ExtraDataType::kHotkey; });
+        const auto fine = Tempered(1.1f);
+        const auto exquisite = Tempered(1.4f);
+        auto* xHotkey = new RE::ExtraHotkey();
+        xHotkey->hotkey = RE::ExtraHotkey::Hotkey::kSlot3;
+        exquisite->Add(xHotkey);
+        entry->extraLists->push_back(fine.get());
+        entry->extraLists->push_back(exquisite.get());
+        Utils::FunctionsSkyrim::Inventory::InvalidateEntryIndex();
+
+        const auto fingerprint = GetInstanceFingerprint(exquisite.get());
+        Check(fingerprint && fingerprint != GetInstanceFingerprint(fine.get()) && !GetInstanceFingerprint(plain),
+              "temper levels tell the stacks apart");
+
+        Reconcile(manager);
+        manager->Publish();
+        Check(manager->GetSnapshot()->GetInstance(formid) == fingerprint, "favorite recorded on its stack");
+        Check(manager->GetSnapshot()->GetHotkey(formid) == 2, "hotkey recorded");
+
+        world.Unfavorite();
+        Reconcile(manager);
+        Check(Hotkey(*exquisite) == 2 && Hotkey(*fine) == -2 && Hotkey(*plain) == -2, "restore picks the same stack");
+
+        SKSE::SerializationInterface cosave;
+        manager->Publish();
+        sink->SaveCallback(&cosave);
+        cosave.started = false;
+        cosave.readRecord = 0;
+        sink->LoadCallback(&cosave);
+        manager->CompleteRestore();
+        Check(manager->GetSnapshot()->GetInstance(formid) == fingerprint, "instance survives a save and load");
+
+        world.Unfavorite();
+        Reconcile(manager);
+        Check(Hotkey(*exquisite) == 2 && Hotkey(*fine) == -2, "restore after load picks the same stack");
+
+        // once the stack is gone the favorite goes on another one rather than being lost
+        std::erase(*entry->extraLists, exquisite.get());
+        Utils::FunctionsSkyrim::Inventory::InvalidateEntryIndex();
+        world.Unfavorite();
+        Reconcile(manager);
+        Check(Hotkey(*plain) == 2 || Hotkey(*fine) == 2, "favorite falls back to another stack");
+
+        manager->Reset();
+    }
+};
+
+int main() {
+    spdlog::set_level(spdlog::level::off);
+    TwoTemperedStacks();
+    return Test::Finish();
+}
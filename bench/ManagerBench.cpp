@@ -0,0 +1,174 @@
+#include <benchmark/benchmark.h>
+#include "World.h"
+
+namespace {
+
+    using Utils::FunctionsSkyrim::Inventory::SnapshotScope;
+
+    // items x spells, from a fresh character to a hoarder
+    void Sizes(benchmark::internal::Benchmark* b) {
+        b->ArgNames({"items", "spells"});
+        b->ArgsProduct({{10, 100, 1000, 20000}, {0, 100, 1000}});
+        b->Unit(benchmark::kMicrosecond);
+    }
+
+    struct Setup {
+        World world;
+        std::unique_ptr<Manager> manager = std::make_unique<Manager>();
+
+        explicit Setup(const benchmark::State& state)
+            : world(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1))) {
+            // learn the favorites the world starts with
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            manager->AddFavorites();
+            manager->Publish();
+        }
+    };
+
+    void SetCounters(benchmark::State& state) {
+        state.SetItemsProcessed(state.iterations() * (state.range(0) + state.range(1)));
+    }
+
+    // Favorites menu hotkey press: records what the player changed.
+    void BM_SyncFavorites(benchmark::State& state) {
+        Setup setup(state);
+        setup.world.OpenFavoritesMenu(true);
+        for (auto _ : state) {
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            setup.manager->SyncFavorites();
+        }
+        SetCounters(state);
+    }
+
+    // Menu open/close when nothing was lost.
+    void BM_AddFavorites(benchmark::State& state) {
+        Setup setup(state);
+        for (auto _ : state) {
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            setup.manager->AddFavorites();
+        }
+        SetCounters(state);
+    }
+
+    // Menu open/close after the game dropped every favorite, e.g. on load.
+    void BM_AddFavorites_Restore(benchmark::State& state) {
+        Setup setup(state);
+        for (auto _ : state) {
+            state.PauseTiming();
+            setup.world.Unfavorite();
+            state.ResumeTiming();
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            setup.manager->AddFavorites();
+        }
+        SetCounters(state);
+    }
+
+    // One hotkey restore with the inventory snapshot an event would build.
+    void BM_ApplyHotkey(benchmark::State& state) {
+        Setup setup(state);
+        const auto& targets = setup.world.favorited_items;
+        std::size_t i = 0;
+        for (auto _ : state) {
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            setup.manager->ApplyHotkey(targets[i++ % targets.size()]);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // One favorited item entering the inventory.
+    void BM_FavoriteCheck_Item(benchmark::State& state) {
+        Setup setup(state);
+        const auto& targets = setup.world.favorited_items;
+        std::size_t i = 0;
+        for (auto _ : state) {
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            setup.manager->FavoriteCheck_Item(targets[i++ % targets.size()]);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // A spell pack of 32 learned spells in one frame, only the learned ones checked.
+    void BM_FavoriteCheck_Spells(benchmark::State& state) {
+        Setup setup(state);
+        const auto& targets = setup.world.favorited_spells;
+        if (targets.empty()) {
+            state.SkipWithError("no spells");
+            return;
+        }
+        std::pmr::vector<FormID> learned;
+        for (auto _ : state) {
+            learned.clear();
+            for (std::size_t i = 0; i < 32; i++) learned.push_back(targets[i % targets.size()]);
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            setup.manager->FavoriteCheck_Spells(learned);
+        }
+        state.SetItemsProcessed(state.iterations() * 32);
+    }
+
+    // The same frame before the delta path: every known spell re-checked.
+    void BM_FavoriteCheck_Spell_All(benchmark::State& state) {
+        Setup setup(state);
+        for (auto _ : state) {
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            setup.manager->FavoriteCheck_Spell();
+        }
+        SetCounters(state);
+    }
+
+    // Cosave load: copy every record out, decode them on the worker, stage and resolve all rows.
+    void BM_ReceiveData(benchmark::State& state) {
+        Setup setup(state);
+        SKSE::SerializationInterface cosave;
+        if (!setup.manager->Save(&cosave, Settings::kDataKey, Settings::kSerializationVersion)) {
+            state.SkipWithError("Save failed");
+            return;
+        }
+        std::size_t n_bytes = 0;
+        for (const auto& record : cosave.records) n_bytes += record.data.size();
+
+        for (auto _ : state) {
+            cosave.started = false;
+            cosave.readRecord = 0;
+            setup.manager->Reset();
+            std::uint32_t type, version, length;
+            while (cosave.GetNextRecordInfo(type, version, length)) {
+                if (!setup.manager->QueueRecord(&cosave, Settings::version_map.at(version), length)) {
+                    state.SkipWithError("Load failed");
+                    return;
+                }
+            }
+            setup.manager->StartDecode(&cosave);
+            setup.manager->ReceiveData(true);
+            setup.manager->EnsureRestored();
+        }
+        SetCounters(state);
+        state.SetBytesProcessed(state.iterations() * n_bytes);
+    }
+};
+
+BENCHMARK(BM_SyncFavorites)->Apply(Sizes);
+BENCHMARK(BM_AddFavorites)->Apply(Sizes);
+BENCHMARK(BM_AddFavorites_Restore)->Apply(Sizes);
+BENCHMARK(BM_ApplyHotkey)->Apply(Sizes);
+BENCHMARK(BM_FavoriteCheck_Item)->Apply(Sizes);
+BENCHMARK(BM_FavoriteCheck_Spells)->Apply(Sizes);
+BENCHMARK(BM_FavoriteCheck_Spell_All)->Apply(Sizes);
+BENCHMARK(BM_ReceiveData)->Apply(Sizes);
+
+int main(int argc, char** argv) {
+    // the passes log every form at trace level; keep the sink out of the numbers
+    spdlog::set_level(spdlog::level::off);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
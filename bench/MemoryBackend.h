@@ -0,0 +1,66 @@
+#pragma once
+#include "Reconciler.h"
+
+// Reconciler backend over plain vectors: no forms, inventory or singletons, so the passes can be profiled on their own.
+class MemoryBackend {
+public:
+    using Instance = Reconciler<MemoryBackend>::Instance;
+
+    struct Form {
+        FormID formid;
+        bool favorited = false;
+        int hotkey = -1;
+        std::uint32_t instance = FavoritesTable::any_instance;
+    };
+
+    std::vector<Form> items;
+    std::vector<Form> spells;
+
+    // Indexes items and spells by FormID. Call after filling them.
+    void Index() {
+        index.clear();
+        for (std::size_t i = 0; i < items.size(); i++) index[items[i].formid] = &items[i];
+        for (std::size_t i = 0; i < spells.size(); i++) index[spells[i].formid] = &spells[i];
+    }
+
+    void Unfavorite() {
+        for (auto& item : items) item.favorited = false;
+        for (auto& spell : spells) spell.favorited = false;
+    }
+
+    template <class F>
+    void ForEachItem(F&& a_visit) {
+        for (const auto& item : items) a_visit(View(item));
+    }
+
+    template <class F>
+    std::size_t ForEachSpell(F&& a_visit) {
+        for (const auto& spell : spells) a_visit(View(spell));
+        return spells.size();
+    }
+
+    std::size_t FavoriteItems(std::span<const Instance> instances) {
+        std::size_t n_favorited = 0;
+        for (const auto& instance : instances) {
+            const auto it = index.find(instance.formid);
+            if (it == index.end()) continue;
+            it->second->favorited = true;
+            it->second->instance = instance.fingerprint;
+            n_favorited++;
+        }
+        return n_favorited;
+    }
+
+    void FavoriteSpell(const FormID formid) {
+        if (const auto it = index.find(formid); it != index.end()) it->second->favorited = true;
+    }
+
+    [[nodiscard]] std::string GetEditorID(const FormID) const { return {}; }
+
+private:
+    std::unordered_map<FormID, Form*> index;
+
+    static FavoriteView View(const Form& form) {
+        return {form.formid, form.favorited, form.favorited ? form.hotkey : -1, form.instance};
+    }
+};
@@ -0,0 +1,104 @@
+// ProfileStore on a plain file: profiles kept apart by character id, surviving a reopen, and what happens when a
+// profile or the slots run out.
+#include <fstream>
+#include "Check.h"
+#include "ProfileStore.h"
+
+namespace {
+
+    using Test::Check;
+
+    FavoritesTable MakeTable(const FormID a_first, const std::size_t a_rows) {
+        FavoritesTable table;
+        for (std::size_t i = 0; i < a_rows; i++) {
+            const auto formid = a_first + static_cast<FormID>(i);
+            table.Insert(formid, i < 8 ? static_cast<int>(i) : -1, std::format("Form{:X}", formid));
+        }
+        return table;
+    }
+
+    // True if rows are the first rows of a_table, with editor IDs too long for a row left empty.
+    bool Holds(const std::span<const ProfileStore::Row> a_rows, const FavoritesTable& a_table) {
+        if (a_rows.size() > a_table.Size()) return false;
+        for (std::size_t i = 0; i < a_rows.size(); i++) {
+            const auto& row = a_rows[i];
+            const auto hotkey = row.hotkey == FavoritesTable::no_hotkey ? -1 : row.hotkey;
+            const auto& editorid = a_table.EditorIDAt(i);
+            const auto stored = editorid.size() <= ProfileStore::editorid_size ? std::string_view(editorid) : "";
+            if (row.formid != a_table.FormIDAt(i) || hotkey != a_table.HotkeyAt(i) ||
+                ProfileStore::EditorID(row) != stored) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Two characters of the same name, as every new game starts out, must not share a profile.
+    void RoundTrip(const std::filesystem::path& a_path) {
+        const auto store = ProfileStore::GetSingleton();
+        Check(store->Open(a_path), "store opens");
+        const auto first = MakeTable(0x100, 10);
+        const auto second = MakeTable(0x900, 5);
+        Check(store->Write(1, "Prisoner", first) && store->Write(2, "Prisoner", second), "profiles written");
+        Check(store->Read(1).size() == first.Size() && Holds(store->Read(1), first), "first profile read back");
+        Check(store->Read(2).size() == second.Size() && Holds(store->Read(2), second), "same name, separate profile");
+        Check(store->Read(3).empty(), "unknown id has no profile");
+        Check(!store->Write(0, "Prisoner", first) && store->Read(0).empty(), "id 0 is never stored");
+
+        store->Close();
+        Check(store->Open(a_path), "store reopens");
+        Check(Holds(store->Read(1), first) && Holds(store->Read(2), second), "profiles survive a reopen");
+
+        auto changed = first;
+        changed.Erase(0x101);
+        changed.SetEditorID(0x105, "Renamed");
+        changed.SetHotkey(0x106, -1);
+        Check(store->Write(1, "Prisoner", changed), "profile rewritten");
+        Check(store->Read(1).size() == changed.Size() && Holds(store->Read(1), changed), "rewrite read back");
+        Check(Holds(store->Read(2), second), "rewrite leaves the other profile alone");
+        store->Close();
+    }
+
+    void Limits(const std::filesystem::path& a_path) {
+        const auto store = ProfileStore::GetSingleton();
+        Check(store->Open(a_path), "store opens");
+
+        // rows past rows_per_profile are dropped, and editor IDs that do not fit are left out
+        auto full = MakeTable(0x1000, ProfileStore::rows_per_profile + 10);
+        full.SetEditorID(0x1000, std::string(ProfileStore::editorid_size + 1, 'x'));
+        Check(store->Write(1, "Full", full), "full profile written");
+        Check(store->Read(1).size() == ProfileStore::rows_per_profile && Holds(store->Read(1), full),
+              "full profile keeps its first rows");
+
+        // once every slot is taken, the profile written longest ago makes room
+        for (std::uint64_t id = 2; id <= ProfileStore::n_profiles; id++) store->Write(id, "Other", MakeTable(0x100, 1));
+        Check(!store->Read(1).empty(), "every slot in use");
+        const auto newcomer = MakeTable(0x200, 3);
+        Check(store->Write(100, "Newcomer", newcomer), "profile written with every slot taken");
+        Check(store->Read(1).empty() && Holds(store->Read(100), newcomer), "stalest profile evicted");
+        Check(!store->Read(2).empty(), "other profiles kept");
+        store->Close();
+
+        // a file of another layout is reset rather than read
+        {
+            std::fstream file(a_path, std::ios::in | std::ios::out | std::ios::binary);
+            const std::uint32_t other_version = ProfileStore::layout_version + 1;
+            file.seekp(offsetof(ProfileStore::Header, version));
+            file.write(reinterpret_cast<const char*>(&other_version), sizeof(other_version));
+        }
+        Check(store->Open(a_path), "store reopens");
+        Check(store->Read(100).empty() && store->Read(2).empty(), "file of another layout reset");
+        store->Close();
+    }
+};
+
+int main() {
+    spdlog::set_level(spdlog::level::off);
+    const auto path = std::filesystem::temp_directory_path() / "PersistentFavoritesProfileTest.bin";
+    std::filesystem::remove(path);
+    RoundTrip(path);
+    std::filesystem::remove(path);
+    Limits(path);
+    std::filesystem::remove(path);
+    return Test::Finish();
+}
@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+#include "MemoryBackend.h"
+
+namespace {
+
+    // The same shapes as the Manager benchmarks: every 4th form favorited, the first 8 favorites hotkeyed.
+    struct MemorySetup {
+        MemoryBackend backend;
+        FavoritesTable data;
+        HotkeySlots slots;
+        Reconciler<MemoryBackend> reconciler{backend, data, slots};
+
+        explicit MemorySetup(const benchmark::State& state) {
+            int next_hotkey = 0;
+            const auto add = [&next_hotkey](std::vector<MemoryBackend::Form>& forms, const FormID base,
+                                            const std::int64_t n) {
+                for (std::int64_t i = 0; i < n; i++) {
+                    auto& form = forms.emplace_back(MemoryBackend::Form{base + static_cast<FormID>(i)});
+                    if (i % 4) continue;
+                    form.favorited = true;
+                    if (next_hotkey < 8) form.hotkey = next_hotkey++;
+                }
+            };
+            add(backend.items, 0x01000000, state.range(0));
+            add(backend.spells, 0x02000000, state.range(1));
+            backend.Index();
+            reconciler.RestoreItems();
+            reconciler.RestoreSpells();
+        }
+    };
+
+    void MemorySizes(benchmark::internal::Benchmark* b) {
+        b->ArgNames({"items", "spells"});
+        b->ArgsProduct({{10, 100, 1000, 20000}, {0, 100, 1000}});
+        b->Unit(benchmark::kMicrosecond);
+    }
+
+    // The reconciliation passes alone, without inventory snapshots or form lookups.
+    void BM_Memory_Record(benchmark::State& state) {
+        MemorySetup setup(state);
+        for (auto _ : state) {
+            setup.reconciler.RecordItems(true);
+            setup.reconciler.RecordSpells(true);
+        }
+        state.SetItemsProcessed(state.iterations() * (state.range(0) + state.range(1)));
+    }
+
+    void BM_Memory_Restore(benchmark::State& state) {
+        MemorySetup setup(state);
+        for (auto _ : state) {
+            state.PauseTiming();
+            setup.backend.Unfavorite();
+            state.ResumeTiming();
+            benchmark::DoNotOptimize(setup.reconciler.RestoreItems());
+            benchmark::DoNotOptimize(setup.reconciler.RestoreSpells());
+        }
+        state.SetItemsProcessed(state.iterations() * (state.range(0) + state.range(1)));
+    }
+
+    // One hotkey change and the copy Publish makes of the table after it.
+    void BM_Memory_Publish(benchmark::State& state) {
+        MemorySetup setup(state);
+        std::size_t row = 0;
+        for (auto _ : state) {
+            const auto formid = setup.data.FormIDAt(row++ % setup.data.Size());
+            setup.data.SetHotkey(formid, setup.data.GetHotkey(formid) < 0 ? 9 : -1);
+            const auto snapshot = std::make_shared<const FavoritesTable>(setup.data);
+            benchmark::DoNotOptimize(snapshot.get());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // A full restore's worth of saved hotkeys, most of them contested, against half-occupied slots.
+    void BM_SolveHotkeys(benchmark::State& state) {
+        std::pmr::vector<std::pair<FormID, unsigned int>> wanted;
+        for (std::int64_t i = 0; i < state.range(0); i++) {
+            wanted.emplace_back(0x01000000 + static_cast<FormID>(i * 7919 % state.range(0)), i % HotkeySlots::n_slots);
+        }
+        std::array<FormID, HotkeySlots::n_slots> owners{};
+        for (unsigned int slot = 0; slot < HotkeySlots::n_slots; slot += 2) owners[slot] = 0x02000000 + slot;
+        for (auto _ : state) benchmark::DoNotOptimize(SolveHotkeys(wanted, owners));
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+};
+
+BENCHMARK(BM_Memory_Record)->Apply(MemorySizes);
+BENCHMARK(BM_Memory_Restore)->Apply(MemorySizes);
+BENCHMARK(BM_Memory_Publish)->Apply(MemorySizes);
+BENCHMARK(BM_SolveHotkeys)->ArgName("wanted")->Range(8, 4096)->Unit(benchmark::kMicrosecond);
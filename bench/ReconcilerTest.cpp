@@ -0,0 +1,99 @@
+// Reconciler passes and SolveHotkeys on the in-memory backend.
+#include <random>
+#include "Check.h"
+#include "MemoryBackend.h"
+
+namespace {
+
+    using Test::Check;
+    using Wanted = std::vector<std::pair<FormID, unsigned int>>;
+
+    HotkeyPlan Solve(const Wanted& a_wanted, const std::array<FormID, HotkeySlots::n_slots>& a_owners) {
+        return SolveHotkeys({a_wanted.begin(), a_wanted.end(), EventArena::Get()}, a_owners);
+    }
+
+    bool SamePlan(const HotkeyPlan& a_lhs, const HotkeyPlan& a_rhs) {
+        return std::ranges::equal(a_lhs.writes, a_rhs.writes) && std::ranges::equal(a_lhs.denied, a_rhs.denied);
+    }
+
+    // The same wanted pairs in any order give the same plan: contested free slots go to the lowest FormID, slots
+    // with an owner stay with it, and owners asking for their own slot need no write.
+    void SolveInAnyOrder() {
+        const EventArena::Scope arena_scope;
+        std::array<FormID, HotkeySlots::n_slots> owners{};
+        owners[2] = 0x50;
+        owners[4] = 0x70;
+        const Wanted wanted{
+            {0x30, 1}, {0x20, 1},  // contested free slot
+            {0x10, 2}, {0x50, 2},  // slot held by 0x50, which asks for it again
+            {0x40, 3}, {0x40, 3},  // repeated pair
+            {0x70, 4},             // already owned, nobody else wants it
+            {0x60, 9},             // out of range
+            {0x80, 5}, {0x80, 6},  // one form, two slots: the lower one counts
+        };
+
+        const auto plan = Solve(wanted, owners);
+        const Wanted writes{{0x20, 1}, {0x40, 3}, {0x80, 5}};
+        const Wanted denied{{0x10, 2}, {0x30, 1}};
+        Check(std::ranges::equal(plan.writes, writes), "free slots go to the lowest FormID");
+        Check(std::ranges::equal(plan.denied, denied), "owned and contested slots are denied to the others");
+
+        auto reversed = wanted;
+        std::ranges::reverse(reversed);
+        Check(SamePlan(Solve(reversed, owners), plan), "reversed order gives the same plan");
+        std::mt19937 rng(1);
+        auto shuffled = wanted;
+        for (int i = 0; i < 100; i++) {
+            std::ranges::shuffle(shuffled, rng);
+            if (!SamePlan(Solve(shuffled, owners), plan)) {
+                Check(false, "shuffled order gives the same plan");
+                break;
+            }
+        }
+    }
+
+    // A restore that visits the inventory in another order must ask for the same hotkeys.
+    HotkeyPlan RestoreInOrder(const bool a_reversed) {
+        MemoryBackend backend;
+        backend.items = {
+            {0x10, true, 2},  // still favorited and holding slot 2
+            {0x20, false},    // saved on slot 2 as well
+            {0x30, false},    // saved on slot 1
+            {0x40, false},    // also saved on slot 1
+            {0x50, false},    // saved on slot 5, free
+        };
+        if (a_reversed) std::ranges::reverse(backend.items);
+        backend.Index();
+
+        FavoritesTable data;
+        const std::vector<FavoritesTable::Row> saved{{0x10, 2}, {0x20, 2}, {0x30, 1}, {0x40, 1}, {0x50, 5}};
+        data.InsertRows(saved);
+        HotkeySlots slots;
+        Reconciler<MemoryBackend> reconciler(backend, data, slots);
+
+        const auto restored = reconciler.RestoreItems();
+        std::pmr::vector<std::pair<FormID, unsigned int>> wanted(EventArena::Get());
+        for (const auto formid : restored) wanted.emplace_back(formid, data.GetHotkey(formid));
+        std::array<FormID, HotkeySlots::n_slots> owners{};
+        for (unsigned int slot = 0; slot < HotkeySlots::n_slots; slot++) owners[slot] = slots.Owner(slot);
+        return SolveHotkeys(std::move(wanted), owners);
+    }
+
+    void RestoreInAnyOrder() {
+        const EventArena::Scope arena_scope;
+        const auto forward = RestoreInOrder(false);
+        const auto backward = RestoreInOrder(true);
+        const Wanted writes{{0x30, 1}, {0x50, 5}};
+        const Wanted denied{{0x20, 2}, {0x40, 1}};
+        Check(std::ranges::equal(forward.writes, writes) && std::ranges::equal(forward.denied, denied),
+              "restore plan keeps the owner and gives contested slots to the lowest FormID");
+        Check(SamePlan(forward, backward), "restore plan does not depend on inventory order");
+    }
+};
+
+int main() {
+    spdlog::set_level(spdlog::level::off);
+    SolveInAnyOrder();
+    RestoreInAnyOrder();
+    return Test::Finish();
+}
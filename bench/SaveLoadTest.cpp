@@ -0,0 +1,303 @@
+// Save and load round trips through the serialization callbacks, on the stand-in game layer. Exits non-zero on the
+// first failed check, for ctest.
+#include "Check.h"
+#include "Events.h"
+#include "World.h"
+
+namespace {
+
+    using Test::Check;
+    using Utils::FunctionsSkyrim::Inventory::SnapshotScope;
+
+    void Rewind(SKSE::SerializationInterface& a_cosave) {
+        a_cosave.started = false;
+        a_cosave.readRecord = 0;
+        a_cosave.readPos = 0;
+    }
+
+    // Favorites the cosave holds, decoded the way a load would.
+    std::size_t CountSaved(SKSE::SerializationInterface& a_cosave) {
+        Rewind(a_cosave);
+        std::size_t n_rows = 0;
+        std::uint32_t type, version, length;
+        while (a_cosave.GetNextRecordInfo(type, version, length)) {
+            if (type != Settings::kDataKey) continue;
+            Utils::RecordReader reader(&a_cosave, length);
+            std::vector<SaveLoadData::SavedRow> rows;
+            const SaveLoadData::Resolver resolve = [](FormID&) { return true; };
+            if (SaveLoadData::Decode(reader, Settings::version_map.at(version), resolve, rows)) n_rows += rows.size();
+        }
+        return n_rows;
+    }
+
+    // The tracked reference records of a cosave, by RefID.
+    std::map<RefID, std::vector<std::uint8_t>> ReferenceRecords(SKSE::SerializationInterface& a_cosave) {
+        std::map<RefID, std::vector<std::uint8_t>> records;
+        for (const auto& [type, version, data] : a_cosave.records) {
+            if (type != Settings::kActorKey || data.size() < sizeof(RefID)) continue;
+            RefID refid;
+            std::memcpy(&refid, data.data(), sizeof(refid));
+            records[refid].assign(data.begin() + sizeof(refid), data.end());
+        }
+        return records;
+    }
+
+    std::vector<SaveLoadData::SavedRow> DecodeReference(const std::vector<std::uint8_t>& a_record) {
+        Utils::RecordReader reader(a_record);
+        std::vector<SaveLoadData::SavedRow> rows;
+        const SaveLoadData::Resolver resolve = [](FormID&) { return true; };
+        if (!SaveLoadData::Decode(reader, Settings::version_map.at(Settings::kSerializationVersion), resolve, rows)) {
+            rows.clear();
+        }
+        return rows;
+    }
+
+    // Records as plugin versions 1 and 2 wrote them: the count and every length as a size_t, and each editor ID
+    // character as a std::pair<int, bool> of the character and whether it was upper case, padding included (0xCC
+    // here, since the old writer never cleared it). Version 2 adds the hotkey after each row.
+    // v34: 0x12EB7 "IronSword", 0x1397E with no editor ID.
+    const std::vector<std::uint8_t> v34_record{
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB7, 0x2E, 0x01, 0x00, 0x09, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x49, 0x00, 0x00, 0x00, 0x01, 0xCC, 0xCC, 0xCC, 0x72, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x6F, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x6E, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x53, 0x00, 0x00, 0x00, 0x01, 0xCC, 0xCC, 0xCC, 0x77, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x6F, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x72, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x64, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x7E, 0x39, 0x01, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+    // v35: 0x12EB7 "IronSword" on hotkey 2, 0x2ACD3 "Flames" without one, and 0x13982 "EbonyBow" on hotkey 7 with
+    // the 'B' saved as not upper case, so it reads back as "Ebonybow".
+    const std::vector<std::uint8_t> v35_record{
+        0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB7, 0x2E, 0x01, 0x00, 0x09, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x49, 0x00, 0x00, 0x00, 0x01, 0xCC, 0xCC, 0xCC, 0x72, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x6F, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x6E, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x53, 0x00, 0x00, 0x00, 0x01, 0xCC, 0xCC, 0xCC, 0x77, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x6F, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x72, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x64, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x02, 0x00, 0x00, 0x00,
+        0xD3, 0xAC, 0x02, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00,
+        0x01, 0xCC, 0xCC, 0xCC, 0x6C, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x61, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x6D, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x65, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x73, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x82, 0x39, 0x01, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x45, 0x00, 0x00, 0x00,
+        0x01, 0xCC, 0xCC, 0xCC, 0x62, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x6F, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x6E, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x79, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x42, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x6F, 0x00, 0x00, 0x00,
+        0x00, 0xCC, 0xCC, 0xCC, 0x77, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0x07, 0x00, 0x00, 0x00,
+    };
+
+    bool Decode(const std::vector<std::uint8_t>& a_record, const std::uint32_t a_version,
+                std::vector<SaveLoadData::SavedRow>& a_rows) {
+        Utils::RecordReader reader(a_record);
+        const SaveLoadData::Resolver resolve = [](FormID&) { return true; };
+        return SaveLoadData::Decode(reader, Settings::version_map.at(a_version), resolve, a_rows);
+    }
+
+    bool IsRow(const SaveLoadData::SavedRow& a_row, const FormID a_formid, const std::string_view a_editorid,
+               const int a_hotkey) {
+        return a_row.formid == a_formid && a_row.editorid == a_editorid && a_row.hotkey == a_hotkey &&
+               a_row.instance == FavoritesTable::any_instance;
+    }
+
+    void LegacyRecords() {
+        std::vector<SaveLoadData::SavedRow> rows;
+        Check(Decode(v34_record, 34, rows), "v34 record decodes");
+        Check(rows.size() == 2 && IsRow(rows[0], 0x12EB7, "IronSword", -1) && IsRow(rows[1], 0x1397E, "", -1),
+              "v34 rows keep FormIDs and editor ID case, without hotkeys");
+
+        rows.clear();
+        Check(Decode(v35_record, 35, rows), "v35 record decodes");
+        Check(rows.size() == 3 && IsRow(rows[0], 0x12EB7, "IronSword", 2) && IsRow(rows[1], 0x2ACD3, "Flames", -1) &&
+                  IsRow(rows[2], 0x13982, "Ebonybow", 7),
+              "v35 rows keep FormIDs, editor ID case and hotkeys");
+
+        // a record cut short anywhere fails instead of reading past its end
+        for (const auto& [record, version] : {std::pair{&v34_record, 34u}, std::pair{&v35_record, 35u}}) {
+            for (std::size_t size = 0; size < record->size(); size++) {
+                rows.clear();
+                const std::vector<std::uint8_t> cut(record->begin(), record->begin() + static_cast<std::ptrdiff_t>(size));
+                if (Decode(cut, version, rows)) {
+                    Check(false, "truncated legacy record rejected");
+                    break;
+                }
+            }
+        }
+    }
+
+    // Tens of thousands of favorites go out in many chunk records and come back as the same rows, in order.
+    void ManyChunks() {
+        World world(100000, 0);
+        const auto sink = myEventSink::GetSingleton();
+        const auto manager = Manager::GetSingleton();
+        {
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            manager->AddFavorites();
+        }
+        manager->Publish();
+        const auto saved = manager->GetSnapshot();
+        Check(saved->Size() == world.favorited_items.size(), "favorites recorded");
+
+        SKSE::SerializationInterface cosave;
+        sink->SaveCallback(&cosave);
+        Rewind(cosave);
+        std::size_t n_records = 0;
+        std::vector<SaveLoadData::SavedRow> rows;
+        std::uint32_t type, version, length;
+        while (cosave.GetNextRecordInfo(type, version, length)) {
+            if (type != Settings::kDataKey) continue;
+            n_records++;
+            Check(version == Settings::kSerializationVersion, "chunks carry the current version");
+            Utils::RecordReader reader(&cosave, length);
+            const SaveLoadData::Resolver resolve = [](FormID&) { return true; };
+            Check(SaveLoadData::Decode(reader, Settings::version_map.at(version), resolve, rows), "chunk decodes");
+        }
+        Check(n_records >= 3 && n_records == (saved->Size() + Settings::chunk_size - 1) / Settings::chunk_size,
+              "one record per chunk");
+        bool same_rows = rows.size() == saved->Size();
+        for (std::size_t row = 0; same_rows && row < rows.size(); row++) {
+            same_rows = rows[row].formid == saved->FormIDAt(row) && rows[row].hotkey == saved->HotkeyAt(row) &&
+                        rows[row].instance == saved->InstanceAt(row);
+        }
+        Check(same_rows, "chunks hold every row in order");
+
+        Rewind(cosave);
+        sink->LoadCallback(&cosave);
+        manager->DumpToLog();
+        Check(manager->GetSnapshot()->Size() == saved->Size(), "load restores every chunk");
+        manager->Reset();
+    }
+
+    // A save made before the deferred restore of the previous load ran must still hold every favorite, in the
+    // cosave and in the character's profile. The same goes for the count DumpStats logs.
+    void SaveRightAfterLoad() {
+        World world(300, 40);
+        const auto sink = myEventSink::GetSingleton();
+        const auto manager = Manager::GetSingleton();
+        const auto store = ProfileStore::GetSingleton();
+        const auto path = std::filesystem::temp_directory_path() / "PersistentFavoritesTest.bin";
+        std::filesystem::remove(path);
+        Check(store->Open(path), "profile store opens");
+
+        {
+            const EventArena::Scope arena_scope;
+            const SnapshotScope snapshot_scope;
+            manager->AddFavorites();
+        }
+        manager->Publish();
+        const auto n_favorites = manager->GetSnapshot()->Size();
+        Check(n_favorites == world.favorited_items.size() + world.favorited_spells.size(), "favorites recorded");
+
+        SKSE::SerializationInterface first_save;
+        sink->SaveCallback(&first_save);
+        Check(CountSaved(first_save) == n_favorites, "first save holds every favorite");
+        const auto id = manager->GetProfileID();
+        Check(store->Read(id).size() == n_favorites, "profile holds every favorite");
+
+        // the load only stages the records; nothing runs the restore before the next save
+        Rewind(first_save);
+        sink->LoadCallback(&first_save);
+        SKSE::SerializationInterface second_save;
+        sink->SaveCallback(&second_save);
+        Check(CountSaved(second_save) == n_favorites, "save right after load holds every favorite");
+        Check(manager->GetProfileID() == id, "load brings back the profile id");
+        Check(store->Read(id).size() == n_favorites, "save right after load keeps the profile");
+
+        // DumpStats reads the count before any frame ran the restore, too
+        Rewind(second_save);
+        sink->LoadCallback(&second_save);
+        manager->DumpToLog();
+        Check(manager->GetSnapshot()->Size() == n_favorites, "dump right after load counts every favorite");
+
+        // a later save of the same character favorited one more item, which this older save must not pick up
+        FavoritesTable later = *manager->GetSnapshot();
+        later.Insert(World::item_base + 1, -1, std::format("BenchItem{:X}", World::item_base + 1));
+        store->Write(id, RE::PlayerCharacter::GetSingleton()->GetName(), later);
+        Rewind(first_save);
+        sink->LoadCallback(&first_save);
+        manager->DumpToLog();
+        Check(manager->GetSnapshot()->Size() == n_favorites, "an older save ignores the favorites of a later one");
+
+        // a save that carries the id but lost its favorites takes them from the profile
+        SKSE::SerializationInterface id_only;
+        Check(manager->SaveProfileID(&id_only), "profile id saved");
+        sink->LoadCallback(&id_only);
+        manager->DumpToLog();
+        Check(manager->GetSnapshot()->Size() == later.Size(), "a save without favorites takes the profile");
+
+        store->Close();
+        std::filesystem::remove(path);
+        manager->Reset();
+    }
+
+    // Tracked references the game never asked for go back out as loaded, unless the load order moved their forms;
+    // references that are gone are dropped.
+    void ReferenceShards() {
+        World world(16, 0);
+        const auto sink = myEventSink::GetSingleton();
+        const auto manager = Manager::GetSingleton();
+        const auto n_favorites = world.favorited_items.size();
+        // two followers carrying the player's items, favorites included
+        RE::TESObjectREFR follower, gone;
+        for (auto [reference, refid] : {std::pair{&follower, RefID{0xFF000801}}, std::pair{&gone, RefID{0xFF000802}}}) {
+            reference->formID = refid;
+            reference->changes.entryList = RE::PlayerCharacter::GetSingleton()->changes.entryList;
+            RE::TESForm::allForms[refid] = reference;
+            manager->TrackReference(refid);
+        }
+
+        SKSE::SerializationInterface first_save;
+        sink->SaveCallback(&first_save);
+        const auto saved = ReferenceRecords(first_save);
+        Check(saved.size() == 2, "one record per tracked reference");
+        Check(std::ranges::all_of(saved, [&](const auto& a_record) {
+                  return DecodeReference(a_record.second).size() == n_favorites;
+              }),
+              "reference records hold every favorite");
+
+        Rewind(first_save);
+        sink->LoadCallback(&first_save);
+        SKSE::SerializationInterface second_save;
+        sink->SaveCallback(&second_save);
+        Check(ReferenceRecords(second_save) == saved, "undecoded records saved as loaded");
+
+        // a reference that no longer resolves is not saved again
+        RE::TESForm::allForms.erase(gone.GetFormID());
+        Rewind(second_save);
+        sink->LoadCallback(&second_save);
+        SKSE::SerializationInterface third_save;
+        sink->SaveCallback(&third_save);
+        const auto kept = ReferenceRecords(third_save);
+        Check(kept.size() == 1 && kept.contains(follower.GetFormID()), "references that are gone are dropped");
+
+        // the plugin of the items moved from index 1 to 3 since the save
+        third_save.moved_plugins = {{World::item_base >> 24, 3}};
+        std::vector<std::unique_ptr<RE::TESBoundObject>> moved_items;
+        for (const auto formid : world.favorited_items) {
+            auto& item = moved_items.emplace_back(std::make_unique<RE::TESBoundObject>());
+            item->formID = 0x03000000 | (formid & 0x00FFFFFF);
+            item->formType = RE::FormType::Armor;
+            RE::TESForm::allForms[item->formID] = item.get();
+        }
+        Rewind(third_save);
+        sink->LoadCallback(&third_save);
+        SKSE::SerializationInterface fourth_save;
+        sink->SaveCallback(&fourth_save);
+        const auto moved = ReferenceRecords(fourth_save);
+        const auto rows = moved.contains(follower.GetFormID()) ? DecodeReference(moved.at(follower.GetFormID()))
+                                                                : std::vector<SaveLoadData::SavedRow>{};
+        const auto moved_plugin = [](const SaveLoadData::SavedRow& a_row) { return a_row.formid >> 24 == 3; };
+        Check(rows.size() == n_favorites && std::ranges::all_of(rows, moved_plugin),
+              "records saved in the new load order after it changed");
+
+        manager->Reset();
+    }
+};
+
+int main() {
+    spdlog::set_level(spdlog::level::off);
+    LegacyRecords();
+    ManyChunks();
+    SaveRightAfterLoad();
+    ReferenceShards();
+    return Test::Finish();
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "Manager.h"
+
+// A player with n_items inventory stacks and n_spells known spells in the stand-in game layer. Every 4th item and
+// spell is favorited and the first 8 favorites hold the hotkeys.
+class World {
+public:
+    static constexpr FormID item_base = 0x01000000;
+    static constexpr FormID spell_base = 0x02000000;
+    static constexpr std::size_t favorite_stride = 4;
+
+    World(const std::size_t a_items, const std::size_t a_spells) {
+        Clear();
+        auto* player = RE::PlayerCharacter::GetSingleton();
+        player->changes.owner = player;
+        player->changes.entryList = &entry_list;
+        auto* mg_favorites = RE::MagicFavorites::GetSingleton();
+        auto* favorites_menu = &menu;
+        RE::UI::GetSingleton()->menus[std::string(RE::FavoritesMenu::MENU_NAME)] = favorites_menu;
+
+        int next_hotkey = 0;
+        for (std::size_t i = 0; i < a_items; i++) {
+            auto& item = items.emplace_back(std::make_unique<RE::TESBoundObject>());
+            Register(*item, item_base + static_cast<FormID>(i), RE::FormType::Armor, "BenchItem");
+
+            auto& entry = entries.emplace_back(std::make_unique<RE::InventoryEntryData>());
+            entry->object = item.get();
+            entry->countDelta = 1;
+            entry_list.push_back(entry.get());
+            if (i % favorite_stride) continue;
+
+            auto& xList = extra_lists.emplace_back(std::make_unique<RE::ExtraDataList>());
+            auto* xHotkey = new RE::ExtraHotkey();
+            if (next_hotkey < 8) xHotkey->hotkey = static_cast<RE::ExtraHotkey::Hotkey>(next_hotkey++);
+            xList->Add(xHotkey);
+            entry->extraLists = new RE::BSSimpleList<RE::ExtraDataList*>{xList.get()};
+            favorites_menu->favorites.push_back({item.get(), entry.get()});
+            favorited_items.push_back(item->GetFormID());
+        }
+
+        for (std::size_t i = 0; i < a_spells; i++) {
+            auto& spell = spells.emplace_back(std::make_unique<RE::SpellItem>());
+            Register(*spell, spell_base + static_cast<FormID>(i), RE::FormType::Spell, "BenchSpell");
+            player->spells.push_back(spell.get());
+            if (i % favorite_stride) continue;
+
+            mg_favorites->spells.push_back(spell.get());
+            if (next_hotkey < 8) mg_favorites->hotkeys[next_hotkey++] = spell.get();
+            favorites_menu->favorites.push_back({spell.get(), nullptr});
+            favorited_spells.push_back(spell->GetFormID());
+        }
+    }
+
+    ~World() { Clear(); }
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Drops every favorite from the game side, as if the game had forgotten them, so a restore pass has work to do.
+    void Unfavorite() {
+        for (auto* entry : entry_list) {
+            if (!entry->extraLists) continue;
+            for (auto* xList : *entry->extraLists) {
+                std::erase_if(xList->data, [](auto& d) { return d->GetType() == RE::ExtraDataType::kHotkey; });
+            }
+        }
+        auto* mg_favorites = RE::MagicFavorites::GetSingleton();
+        mg_favorites->spells.clear();
+        std::ranges::fill(mg_favorites->hotkeys, nullptr);
+    }
+
+    void OpenFavoritesMenu(const bool a_open) {
+        auto& open = RE::UI::GetSingleton()->open;
+        if (a_open) open.emplace(RE::FavoritesMenu::MENU_NAME);
+        else open.erase(std::string(RE::FavoritesMenu::MENU_NAME));
+    }
+
+    std::vector<FormID> favorited_items;
+    std::vector<FormID> favorited_spells;
+
+private:
+    std::vector<std::unique_ptr<RE::TESBoundObject>> items;
+    std::vector<std::unique_ptr<RE::SpellItem>> spells;
+    std::vector<std::unique_ptr<RE::InventoryEntryData>> entries;
+    std::vector<std::unique_ptr<RE::ExtraDataList>> extra_lists;
+    RE::BSSimpleList<RE::InventoryEntryData*> entry_list;
+    RE::FavoritesMenu menu;
+
+    static void Register(RE::TESForm& form, const FormID formid, const RE::FormType type, std::string_view prefix) {
+        form.formID = formid;
+        form.formType = type;
+        form.editorID = std::format("{}{:X}", prefix, formid);
+        form.name = form.editorID;
+        RE::TESForm::allForms[formid] = &form;
+        RE::TESForm::allEditorIDs[form.editorID] = &form;
+    }
+
+    void Clear() {
+        RE::TESForm::allForms.clear();
+        RE::TESForm::allEditorIDs.clear();
+        auto* player = RE::PlayerCharacter::GetSingleton();
+        player->spells.clear();
+        player->changes.entryList = nullptr;
+        auto* mg_favorites = RE::MagicFavorites::GetSingleton();
+        mg_favorites->spells.clear();
+        std::ranges::fill(mg_favorites->hotkeys, nullptr);
+        auto* ui = RE::UI::GetSingleton();
+        ui->open.clear();
+        ui->menus.clear();
+        Utils::FunctionsSkyrim::Inventory::InvalidateSnapshot();
+        Utils::FunctionsSkyrim::Inventory::InvalidateEntryIndex();
+    }
+};
@@ -0,0 +1,4 @@
+#pragma once
+namespace clib_util::editorID {
+    inline std::string get_editorID(const RE::TESForm* a_form) { return a_form ? a_form->editorID : std::string{}; }
+}
@@ -0,0 +1,541 @@
+#pragma once
+// In-memory stand-in for the CommonLibSSE surfaces the plugin uses: forms, inventories, MagicFavorites, the spell
+// visitor, menus and events. Only as much behaviour as Manager relies on, so the reconciliation code runs on a host.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <tuple>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <version>
+#include <fmt/format.h>
+#if !defined(__cpp_lib_format)
+namespace std { using fmt::format; }
+#endif
+
+namespace RE {
+    using FormID = std::uint32_t;
+
+    template <class T>
+    struct BSTArray : std::vector<T> {
+        using std::vector<T>::vector;
+    };
+    template <class T>
+    struct BSSimpleList : std::list<T> {
+        using std::list<T>::list;
+    };
+
+    class BSFixedString {
+        std::string s;
+    public:
+        BSFixedString() = default;
+        BSFixedString(const char* a) : s(a ? a : "") {}
+        BSFixedString(std::string_view a) : s(a) {}
+        const char* c_str() const { return s.c_str(); }
+        const char* data() const { return s.c_str(); }
+        bool empty() const { return s.empty(); }
+        bool operator==(const BSFixedString& o) const { return s == o.s; }
+        bool operator==(std::string_view o) const { return s == o; }
+    };
+
+    namespace BSContainer {
+        enum class ForEachResult { kStop, kContinue };
+    }
+
+    enum class FormType : std::uint8_t { None = 0, Armor = 26, Weapon = 41, Spell = 22, Misc = 32 };
+
+    class TESForm {
+    public:
+        FormID formID = 0;
+        std::string name;
+        std::string editorID;
+        FormType formType = FormType::None;
+        bool deleted = false;
+        virtual ~TESForm() = default;
+        FormID GetFormID() const { return formID; }
+        bool IsDeleted() const { return deleted; }
+        const char* GetName() const { return name.c_str(); }
+        FormType GetFormType() const { return formType; }
+        bool IsPlayable() const { return true; }
+        template <class T>
+        T* As() { return dynamic_cast<T*>(this); }
+        template <class T>
+        const T* As() const { return dynamic_cast<const T*>(this); }
+
+        static inline std::unordered_map<FormID, TESForm*> allForms;
+        static inline std::unordered_map<std::string, TESForm*> allEditorIDs;
+
+        template <class T = TESForm>
+        static T* LookupByID(FormID id) {
+            auto it = allForms.find(id);
+            return it == allForms.end() ? nullptr : dynamic_cast<T*>(it->second);
+        }
+        template <class T = TESForm>
+        static T* LookupByEditorID(std::string_view id) {
+            auto it = allEditorIDs.find(std::string(id));
+            return it == allEditorIDs.end() ? nullptr : dynamic_cast<T*>(it->second);
+        }
+    };
+
+    class TESBoundObject : public TESForm {};
+    class MagicItem : public TESBoundObject {};
+    class SpellItem : public MagicItem {};
+    class EnchantmentItem : public MagicItem {};
+
+    enum class ExtraDataType : std::uint32_t { kHotkey = 0x4A, kEnchantment = 0x9B, kHealth = 0x25, kUniqueID = 0x7C, kCount = 0x24 };
+
+    class BSExtraData {
+    public:
+        virtual ~BSExtraData() = default;
+        virtual ExtraDataType GetType() const = 0;
+        template <class T>
+        static T* Create() { return new T(); }
+    };
+
+    namespace stl {
+        template <class E, class U = std::underlying_type_t<E>>
+        struct enumeration {
+            U v{};
+            enumeration() = default;
+            enumeration(E e) : v(static_cast<U>(e)) {}
+            enumeration& operator=(E e) { v = static_cast<U>(e); return *this; }
+            E get() const { return static_cast<E>(v); }
+            U underlying() const { return v; }
+            bool operator==(E e) const { return get() == e; }
+        };
+    }
+
+    class ExtraHotkey : public BSExtraData {
+    public:
+        enum class Hotkey : std::int8_t { kUnbound = -1, kSlot1 = 0, kSlot2, kSlot3, kSlot4, kSlot5, kSlot6, kSlot7, kSlot8 };
+        inline static constexpr auto EXTRADATATYPE = ExtraDataType::kHotkey;
+        ExtraDataType GetType() const override { return EXTRADATATYPE; }
+        stl::enumeration<Hotkey, std::int8_t> hotkey{Hotkey::kUnbound};
+    };
+
+    class ExtraEnchantment : public BSExtraData {
+    public:
+        inline static constexpr auto EXTRADATATYPE = ExtraDataType::kEnchantment;
+        ExtraDataType GetType() const override { return EXTRADATATYPE; }
+        EnchantmentItem* enchantment = nullptr;
+        std::uint16_t charge = 0;
+    };
+
+    class ExtraHealth : public BSExtraData {
+    public:
+        inline static constexpr auto EXTRADATATYPE = ExtraDataType::kHealth;
+        ExtraDataType GetType() const override { return EXTRADATATYPE; }
+        float health = 1.f;
+    };
+
+    class ExtraUniqueID : public BSExtraData {
+    public:
+        inline static constexpr auto EXTRADATATYPE = ExtraDataType::kUniqueID;
+        ExtraDataType GetType() const override { return EXTRADATATYPE; }
+        FormID baseID = 0;
+        std::uint16_t uniqueID = 0;
+    };
+
+    class ExtraDataList {
+    public:
+        std::vector<std::unique_ptr<BSExtraData>> data;
+        bool HasType(ExtraDataType t) const {
+            return std::ranges::any_of(data, [t](auto& d) { return d->GetType() == t; });
+        }
+        template <class T>
+        bool HasType() const { return HasType(T::EXTRADATATYPE); }
+        template <class T>
+        T* GetByType() const {
+            for (auto& d : data)
+                if (d->GetType() == T::EXTRADATATYPE) return static_cast<T*>(d.get());
+            return nullptr;
+        }
+        BSExtraData* Add(BSExtraData* d) { data.emplace_back(d); return d; }
+    };
+
+    class InventoryEntryData {
+    public:
+        TESBoundObject* object = nullptr;
+        BSSimpleList<ExtraDataList*>* extraLists = nullptr;
+        std::int32_t countDelta = 0;
+        InventoryEntryData() = default;
+        InventoryEntryData(const InventoryEntryData& o) : object(o.object), countDelta(o.countDelta) {
+            if (o.extraLists) extraLists = new BSSimpleList<ExtraDataList*>(*o.extraLists);
+        }
+        ~InventoryEntryData() { delete extraLists; }
+        TESBoundObject* GetObject() const { return object; }
+        bool IsFavorited() const {
+            if (!extraLists) return false;
+            for (auto* x : *extraLists)
+                if (x && x->HasType(ExtraDataType::kHotkey)) return true;
+            return false;
+        }
+        bool IsWorn() const { return false; }
+    };
+
+    class TESObjectREFR;
+
+    class InventoryChanges {
+    public:
+        BSSimpleList<InventoryEntryData*>* entryList = nullptr;
+        TESObjectREFR* owner = nullptr;
+        std::uint16_t changed = 0;
+        void SetFavorite(InventoryEntryData* a_entry, ExtraDataList* a_itemList);
+        void RemoveFavorite(InventoryEntryData* a_entry, ExtraDataList* a_itemList);
+    };
+
+    enum class ITEM_REMOVE_REASON { kRemove };
+
+    using RefHandle = std::uint32_t;
+
+    class TESObjectREFR : public TESForm {
+    public:
+        using Count = std::int32_t;
+        using InventoryItemMap = std::map<TESBoundObject*, std::pair<Count, std::unique_ptr<InventoryEntryData>>>;
+        InventoryChanges changes;
+        TESObjectREFR* AsReference() { return this; }
+        InventoryChanges* GetInventoryChanges() { return &changes; }
+        InventoryItemMap GetInventory() {
+            InventoryItemMap r;
+            if (!changes.entryList) return r;
+            for (auto* e : *changes.entryList) {
+                if (!e || !e->object) continue;
+                r.emplace(e->object, std::make_pair(e->countDelta, std::make_unique<InventoryEntryData>(*e)));
+            }
+            return r;
+        }
+        void RemoveItem(TESBoundObject*, std::int32_t, ITEM_REMOVE_REASON, ExtraDataList*, TESObjectREFR*) {}
+        // handles are FormIDs here
+        static TESObjectREFR* LookupByHandle(RefHandle a_handle) { return LookupByID<TESObjectREFR>(a_handle); }
+    };
+
+    inline void InventoryChanges::SetFavorite(InventoryEntryData* a_entry, ExtraDataList* a_itemList) {
+        if (!a_entry) return;
+        if (!a_itemList) {
+            if (!a_entry->extraLists) a_entry->extraLists = new BSSimpleList<ExtraDataList*>();
+            a_itemList = new ExtraDataList();
+            a_entry->extraLists->push_front(a_itemList);
+        }
+        if (!a_itemList->HasType(ExtraDataType::kHotkey)) a_itemList->Add(new ExtraHotkey());
+    }
+    inline void InventoryChanges::RemoveFavorite(InventoryEntryData* a_entry, ExtraDataList* a_itemList) {
+        if (!a_entry || !a_itemList) return;
+        std::erase_if(a_itemList->data, [](auto& d) { return d->GetType() == ExtraDataType::kHotkey; });
+    }
+
+    class Actor : public TESObjectREFR {
+    public:
+        class ForEachSpellVisitor {
+        public:
+            virtual ~ForEachSpellVisitor() = default;
+            virtual BSContainer::ForEachResult Visit(SpellItem* a_spell) = 0;
+        };
+        std::vector<SpellItem*> spells;
+        void VisitSpells(ForEachSpellVisitor& v) {
+            for (auto* s : spells)
+                if (v.Visit(s) == BSContainer::ForEachResult::kStop) return;
+        }
+        bool HasSpell(SpellItem* s) const { return std::ranges::find(spells, s) != spells.end(); }
+        bool AddSpell(SpellItem* s) { if (HasSpell(s)) return false; spells.push_back(s); return true; }
+        bool teammate = false;
+        bool IsPlayerTeammate() const { return teammate; }
+    };
+
+    class PlayerCharacter : public Actor {
+    public:
+        static PlayerCharacter* GetSingleton() {
+            static PlayerCharacter p;
+            return &p;
+        }
+    };
+
+    template <class T>
+    class BSTSingletonSDM {};
+
+    class TESFile {};
+
+    // the plugins loaded now, by index; empty unless a test sets them
+    class TESDataHandler {
+    public:
+        std::map<std::uint8_t, TESFile> mods;
+        std::map<std::uint16_t, TESFile> light_mods;
+        static TESDataHandler* GetSingleton() {
+            static TESDataHandler d;
+            return &d;
+        }
+        const TESFile* LookupLoadedModByIndex(std::uint8_t a_index) const {
+            const auto it = mods.find(a_index);
+            return it == mods.end() ? nullptr : &it->second;
+        }
+        const TESFile* LookupLoadedLightModByIndex(std::uint16_t a_index) const {
+            const auto it = light_mods.find(a_index);
+            return it == light_mods.end() ? nullptr : &it->second;
+        }
+    };
+
+    class MagicFavorites : public BSTSingletonSDM<MagicFavorites> {
+    public:
+        BSTArray<TESForm*> spells;
+        BSTArray<TESForm*> hotkeys = BSTArray<TESForm*>(8, nullptr);
+        static MagicFavorites* GetSingleton() {
+            static MagicFavorites m;
+            return &m;
+        }
+        void SetFavorite(TESForm* f) {
+            if (std::ranges::find(spells, f) == spells.end()) spells.push_back(f);
+        }
+        void RemoveFavorite(TESForm* f) {
+            std::erase(spells, f);
+            for (auto& h : hotkeys)
+                if (h == f) h = nullptr;
+        }
+    };
+
+    // events / UI
+    enum class BSEventNotifyControl { kContinue, kStop };
+    template <class E>
+    class BSTEventSource;
+    template <class E>
+    class BSTEventSink {
+    public:
+        virtual ~BSTEventSink() = default;
+        virtual BSEventNotifyControl ProcessEvent(const E* a_event, BSTEventSource<E>* a_source) = 0;
+    };
+    template <class E>
+    class BSTEventSource {
+    public:
+        void AddEventSink(BSTEventSink<E>*) {}
+    };
+
+    class MenuOpenCloseEvent {
+    public:
+        BSFixedString menuName;
+        bool opening = false;
+    };
+    class TESContainerChangedEvent {
+    public:
+        FormID oldContainer = 0;
+        FormID newContainer = 0;
+        FormID baseObj = 0;
+        std::int32_t itemCount = 0;
+        FormID reference = 0;
+        std::uint16_t uniqueID = 0;
+    };
+    struct SpellsLearned {
+        struct Event {
+            SpellItem* spell = nullptr;
+        };
+        static BSTEventSource<Event>* GetEventSource() {
+            static BSTEventSource<Event> s;
+            return &s;
+        }
+    };
+
+    enum class INPUT_EVENT_TYPE { kButton, kMouseMove, kChar, kThumbstick, kDeviceConnect, kKinect };
+    class ButtonEvent;
+    class IDEvent;
+    class InputEvent {
+    public:
+        virtual ~InputEvent() = default;
+        stl::enumeration<INPUT_EVENT_TYPE, std::uint32_t> eventType;
+        InputEvent* next = nullptr;
+        ButtonEvent* AsButtonEvent();
+        IDEvent* AsIDEvent();
+    };
+    class IDEvent : public InputEvent {
+    public:
+        BSFixedString userEvent;
+        std::uint32_t idCode = 0;
+    };
+    class ButtonEvent : public IDEvent {
+    public:
+        float value = 0.f;
+        float heldDownSecs = 0.f;
+        bool IsPressed() const { return value > 0.f; }
+        bool IsHeld() const { return IsPressed() && heldDownSecs > 0.f; }
+    };
+    inline ButtonEvent* InputEvent::AsButtonEvent() { return static_cast<ButtonEvent*>(this); }
+    inline IDEvent* InputEvent::AsIDEvent() { return static_cast<IDEvent*>(this); }
+
+    class BSInputDeviceManager : public BSTEventSource<InputEvent*> {
+    public:
+        static BSInputDeviceManager* GetSingleton() {
+            static BSInputDeviceManager s;
+            return &s;
+        }
+    };
+
+    class UserEvents {
+    public:
+        BSFixedString toggleFavorite{"Toggle Favorite"};
+        BSFixedString yButton{"Y Button"};
+        BSFixedString hotkey1{"Hotkey1"};
+        BSFixedString hotkey2{"Hotkey2"};
+        BSFixedString hotkey3{"Hotkey3"};
+        BSFixedString hotkey4{"Hotkey4"};
+        BSFixedString hotkey5{"Hotkey5"};
+        BSFixedString hotkey6{"Hotkey6"};
+        BSFixedString hotkey7{"Hotkey7"};
+        BSFixedString hotkey8{"Hotkey8"};
+        static UserEvents* GetSingleton() {
+            static UserEvents s;
+            return &s;
+        }
+    };
+
+    template <class T>
+    class GPtr {
+        T* p = nullptr;
+    public:
+        GPtr() = default;
+        GPtr(T* a) : p(a) {}
+        T* get() const { return p; }
+        T* operator->() const { return p; }
+        explicit operator bool() const { return p != nullptr; }
+    };
+    class IMenu {
+    public:
+        virtual ~IMenu() = default;
+    };
+    class FavoritesMenu : public IMenu {
+    public:
+        struct Entry {
+            TESForm* item = nullptr;
+            InventoryEntryData* entryData = nullptr;
+        };
+        static constexpr std::string_view MENU_NAME = "FavoritesMenu";
+        BSTArray<Entry> favorites;
+    };
+    struct InventoryMenu { static constexpr std::string_view MENU_NAME = "InventoryMenu"; };
+    struct ContainerMenu {
+        static constexpr std::string_view MENU_NAME = "ContainerMenu";
+        static inline RefHandle target = 0;
+        static RefHandle GetTargetRefHandle() { return target; }
+    };
+    struct MagicMenu { static constexpr std::string_view MENU_NAME = "MagicMenu"; };
+
+    class UI : public BSTEventSource<MenuOpenCloseEvent> {
+    public:
+        std::set<std::string> open;
+        static UI* GetSingleton() {
+            static UI s;
+            return &s;
+        }
+        bool IsMenuOpen(const BSFixedString& n) const { return open.contains(n.c_str()); }
+        template <class E>
+        void AddEventSink(BSTEventSink<E>*) {}
+        std::map<std::string, IMenu*> menus;
+        template <class T>
+        GPtr<T> GetMenu() {
+            if (!IsMenuOpen(BSFixedString(T::MENU_NAME))) return nullptr;
+            auto it = menus.find(std::string(T::MENU_NAME));
+            return it == menus.end() ? nullptr : static_cast<T*>(it->second);
+        }
+    };
+    enum class UI_MESSAGE_TYPE { kShow, kHide };
+    class UIMessageQueue {
+    public:
+        static UIMessageQueue* GetSingleton() {
+            static UIMessageQueue s;
+            return &s;
+        }
+        void AddMessage(const BSFixedString&, UI_MESSAGE_TYPE, void*) {}
+    };
+    namespace SendUIMessage {
+        inline void SendInventoryUpdateMessage(TESObjectREFR*, const TESBoundObject*) {}
+    }
+    class ScriptEventSourceHolder : public BSTEventSource<TESContainerChangedEvent> {
+    public:
+        static ScriptEventSourceHolder* GetSingleton() {
+            static ScriptEventSourceHolder s;
+            return &s;
+        }
+        template <class E>
+        void AddEventSink(BSTEventSink<E>*) {}
+    };
+
+    class BSScript {
+    public:
+        class IVirtualMachine {
+        public:
+            template <class F>
+            void RegisterFunction(std::string_view, std::string_view, F) {}
+        };
+    };
+    class StaticFunctionTag {};
+
+    namespace Offset {}
+}
+
+namespace REL {
+    struct ID {
+        explicit constexpr ID(std::uint64_t a) : id(a) {}
+        std::uint64_t id;
+    };
+    struct RelocationID {
+        constexpr RelocationID(std::uint64_t a_se, std::uint64_t a_ae) : se(a_se), ae(a_ae) {}
+        std::uint64_t se, ae;
+    };
+    struct VariantOffset {
+        constexpr VariantOffset(std::ptrdiff_t a_se, std::ptrdiff_t a_ae, std::ptrdiff_t a_vr)
+            : se(a_se), ae(a_ae), vr(a_vr) {}
+        std::ptrdiff_t se, ae, vr;
+    };
+    template <class T>
+    class Relocation {
+        std::uintptr_t addr = 0;
+    public:
+        Relocation() = default;
+        Relocation(ID) {}
+        Relocation(RelocationID) {}
+        Relocation(RelocationID, VariantOffset) {}
+        Relocation(std::uintptr_t a) : addr(a) {}
+        std::uintptr_t address() const { return addr; }
+        Relocation& operator=(std::uintptr_t a) { addr = a; return *this; }
+        template <class... Args>
+        decltype(auto) operator()(Args&&... args) const {
+            return reinterpret_cast<std::add_pointer_t<T>>(addr)(std::forward<Args>(args)...);
+        }
+    };
+    inline void safe_write(std::uintptr_t, const void*, std::size_t) {}
+
+    // no game code on the host
+    class Segment {
+    public:
+        enum Name { textx };
+        std::uintptr_t address() const { return 0; }
+        std::size_t size() const { return 0; }
+    };
+    class Module {
+    public:
+        static Module& get() {
+            static Module m;
+            return m;
+        }
+        Segment segment(Segment::Name) const { return {}; }
+    };
+}
+#define RELOCATION_ID(se, ae) REL::RelocationID(se, ae)
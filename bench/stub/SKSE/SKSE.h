@@ -0,0 +1,160 @@
+#pragma once
+// Stand-in for the SKSE interfaces the plugin uses. Tasks queue until Drain() is called.
+#include "RE/Skyrim.h"
+#include <spdlog/spdlog.h>
+
+namespace SKSE {
+    struct Version {
+        int a = 0, b = 3, c = 1, d = 0;
+        int major() const { return a; }
+        int minor() const { return b; }
+        int patch() const { return c; }
+        int build() const { return d; }
+    };
+    class PluginDeclaration {
+    public:
+        static PluginDeclaration* GetSingleton() {
+            static PluginDeclaration p;
+            return &p;
+        }
+        std::string_view GetName() const { return "PersistentFavorites"; }
+        Version GetVersion() const { return {}; }
+    };
+
+    namespace log {
+        using spdlog::critical;
+        using spdlog::debug;
+        using spdlog::error;
+        using spdlog::info;
+        using spdlog::trace;
+        using spdlog::warn;
+        inline std::optional<std::filesystem::path> log_directory() { return std::filesystem::temp_directory_path(); }
+    }
+
+    namespace stl {
+        [[noreturn]] inline void report_and_fail(std::string_view) { std::abort(); }
+    }
+
+    class SerializationInterface {
+    public:
+        // one growing blob per record, in order
+        struct Record {
+            std::uint32_t type, version;
+            std::vector<std::uint8_t> data;
+        };
+        std::vector<Record> records;
+        std::size_t readRecord = 0, readPos = 0;
+        bool started = false;
+
+        bool OpenRecord(std::uint32_t type, std::uint32_t version) {
+            records.push_back({type, version, {}});
+            return true;
+        }
+        bool WriteRecordData(const void* buf, std::uint32_t length) {
+            auto p = static_cast<const std::uint8_t*>(buf);
+            records.back().data.insert(records.back().data.end(), p, p + length);
+            return true;
+        }
+        template <class T>
+        bool WriteRecordData(const T& v) { return WriteRecordData(&v, sizeof(T)); }
+        bool GetNextRecordInfo(std::uint32_t& type, std::uint32_t& version, std::uint32_t& length) {
+            if (started) readRecord++;
+            started = true;
+            readPos = 0;
+            if (readRecord >= records.size()) return false;
+            type = records[readRecord].type;
+            version = records[readRecord].version;
+            length = static_cast<std::uint32_t>(records[readRecord].data.size());
+            return true;
+        }
+        std::uint32_t ReadRecordData(void* buf, std::uint32_t length) {
+            auto& d = records[readRecord].data;
+            const auto n = std::min<std::size_t>(length, d.size() - readPos);
+            std::memcpy(buf, d.data() + readPos, n);
+            readPos += n;
+            return static_cast<std::uint32_t>(n);
+        }
+        template <class T>
+        bool ReadRecordData(T& v) { return ReadRecordData(&v, sizeof(T)) == sizeof(T); }
+        // saved plugin index to loaded index, for plugins that moved since the save; every other index stays put
+        std::map<std::uint32_t, std::uint32_t> moved_plugins;
+        bool ResolveFormID(RE::FormID a, RE::FormID& b) const {
+            const auto it = moved_plugins.find(a >> 24);
+            b = it == moved_plugins.end() ? a : it->second << 24 | (a & 0x00FFFFFF);
+            return true;
+        }
+        void SetUniqueID(std::uint32_t) {}
+        void SetSaveCallback(void (*)(SerializationInterface*)) {}
+        void SetLoadCallback(void (*)(SerializationInterface*)) {}
+        void SetRevertCallback(void (*)(SerializationInterface*)) {}
+    };
+    inline SerializationInterface* GetSerializationInterface() {
+        static SerializationInterface s;
+        return &s;
+    }
+
+    class TaskInterface {
+    public:
+        std::vector<std::function<void()>> queue;
+        void AddTask(std::function<void()> f) { queue.push_back(std::move(f)); }
+        void AddUITask(std::function<void()> f) { queue.push_back(std::move(f)); }
+        void Drain() {
+            auto q = std::move(queue);
+            queue.clear();
+            for (auto& f : q) f();
+        }
+    };
+    inline TaskInterface* GetTaskInterface() {
+        static TaskInterface t;
+        return &t;
+    }
+
+    class MessagingInterface {
+    public:
+        enum : std::uint32_t { kPostLoad, kPostPostLoad, kPreLoadGame, kPostLoadGame, kSaveGame, kDeleteGame, kInputLoaded, kNewGame, kDataLoaded };
+        struct Message {
+            std::uint32_t type;
+            std::uint32_t dataLen;
+            void* data;
+        };
+        bool RegisterListener(void (*)(Message*)) { return true; }
+    };
+    inline MessagingInterface* GetMessagingInterface() {
+        static MessagingInterface m;
+        return &m;
+    }
+
+    class Trampoline {
+    public:
+        void* allocate(std::size_t n) { return std::malloc(n); }
+        template <std::size_t N>
+        std::uintptr_t write_branch(std::uintptr_t, std::uintptr_t) { return 0; }
+        template <std::size_t N, class F>
+        std::uintptr_t write_branch(std::uintptr_t a, F f) { return write_branch<N>(a, reinterpret_cast<std::uintptr_t>(f)); }
+        template <std::size_t N>
+        std::uintptr_t write_call(std::uintptr_t, std::uintptr_t) { return 0; }
+    };
+    inline Trampoline& GetTrampoline() {
+        static Trampoline t;
+        return t;
+    }
+    inline void AllocTrampoline(std::size_t) {}
+
+    class PapyrusInterface {
+    public:
+        template <class F>
+        bool Register(F) { return true; }
+    };
+    inline PapyrusInterface* GetPapyrusInterface() {
+        static PapyrusInterface p;
+        return &p;
+    }
+
+    struct LoadInterface {};
+    inline void Init(const LoadInterface*) {}
+}
+#define SKSEPluginLoad(...) bool SKSEPlugin_Load(__VA_ARGS__)
+template <>
+struct fmt::formatter<SKSE::Version> : fmt::formatter<int> {
+    auto format(const SKSE::Version& v, fmt::format_context& ctx) const { return fmt::formatter<int>::format(v.b, ctx); }
+};
@@ -0,0 +1,5 @@
+#pragma once
+// Only what Utils needs outside of Windows.
+#define MB_OK 0
+#define MB_ICONERROR 0x10
+inline int MessageBoxA(void*, const char*, const char*, unsigned) { return 0; }
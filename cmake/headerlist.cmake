@@ -3,6 +3,15 @@ set(headers ${headers}
 	include/Settings.h
 	include/Serialization.h
 	include/Manager.h
+	include/Reconciler.h
+	include/SkyrimBackend.h
+	include/ActorShards.h
 	include/Events.h
 	include/Hooks.h
+	include/FavoritesTable.h
+	include/FormCache.h
+	include/ProfileStore.h
+	include/Stats.h
+	include/EventArena.h
+	include/Papyrus.h
 )
\ No newline at end of file
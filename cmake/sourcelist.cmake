@@ -3,6 +3,15 @@ set(sources ${sources}
 	src/plugin.cpp
 	src/Utils.cpp
 	src/Manager.cpp
+	src/Reconciler.cpp
+	src/SkyrimBackend.cpp
+	src/ActorShards.cpp
 	src/Hooks.cpp
+	src/FavoritesTable.cpp
+	src/FormCache.cpp
+	src/ProfileStore.cpp
+	src/Stats.cpp
+	src/EventArena.cpp
+	src/Papyrus.cpp
 	Serialization.cpp
 )
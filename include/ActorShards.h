@@ -0,0 +1,129 @@
+#pragma once
+#include "Serialization.h"
+#include "SkyrimBackend.h"
+
+// Reconciler backend over the inventory of a reference other than the player. They have no magic favorites.
+class ReferenceBackend {
+public:
+    using Instance = Utils::FunctionsSkyrim::Inventory::Instance;
+
+    explicit ReferenceBackend(RE::TESObjectREFR* a_owner) : owner(a_owner) {}
+
+    template <class F>
+    void ForEachItem(F&& a_visit) {
+        SkyrimBackend::ForEachItem(owner, std::forward<F>(a_visit));
+    }
+
+    template <class F>
+    std::size_t ForEachSpell(F&&) {
+        return 0;
+    }
+
+    inline std::size_t FavoriteItems(std::span<const Instance> instances) {
+        return Utils::FunctionsSkyrim::Inventory::FavoriteItems(instances, owner);
+    };
+
+    inline void FavoriteSpell(const FormID) {};
+
+    [[nodiscard]] inline std::string GetEditorID(const FormID formid) {
+        return FormCache::GetSingleton()->GetEditorID(formid);
+    };
+
+private:
+    RE::TESObjectREFR* owner;
+};
+
+// Favorites of followers, mannequins and containers, one shard per RefID. An event only touches the shard of its own
+// reference and the player's table never goes through here, so tracked references cost the player path nothing.
+// Each shard is saved as its own cosave record and only decoded once the game asks for it.
+class ActorShards {
+public:
+    [[nodiscard]] inline bool IsTracked(const RefID refid) const { return shards.contains(refid); };
+
+    [[nodiscard]] inline std::size_t Size() const { return shards.size(); };
+
+    // Starts remembering the favorites of refid and records the ones it has now. The player is never tracked here.
+    void Track(RefID refid);
+
+    void Untrack(const RefID refid);
+
+    // Queues an item that entered refid for the next Drain. Returns false if refid is not tracked. Safe to call from
+    // any thread.
+    bool QueueItem(const RefID refid, const FormID formid);
+
+    // Records the favorites refid has now; favorites it dropped while holding the item are forgotten.
+    void Record(const RefID refid);
+
+    // Favorites again every saved item refid holds without the favorite.
+    void Restore(const RefID refid);
+
+    // Restores the items queued since the last drain, shard by shard. Returns the number of items restored.
+    std::size_t Drain();
+
+    // Keeps the record of one reference undecoded until it is first used.
+    [[nodiscard]] bool QueueRecord(SKSE::SerializationInterface* serializationInterface, unsigned int plugin_version,
+                                   std::uint32_t length);
+
+    // Captures the load order for the shards still undecoded. Call once every record has been queued.
+    void FinishLoad(SKSE::SerializationInterface* serializationInterface);
+
+    // Publishes the shards for Save if any changed since the last publish. Only the game thread calls this.
+    void Publish();
+
+    // Stops tracking references that were deleted or no longer resolve. Returns the number dropped.
+    std::size_t Prune();
+
+    // Writes the last published shards; the live ones are neither read nor decoded here. Undecoded records go out as
+    // they came in unless the load order changed since.
+    [[nodiscard]] bool Save(SKSE::SerializationInterface* serializationInterface, std::uint32_t type,
+                            std::uint32_t version) const;
+
+    void Clear();
+
+private:
+    struct Shard {
+        FavoritesTable data;
+        std::vector<FormID> pending;  // items that entered since the last drain
+        // cosave record not decoded yet, shared with the published shards
+        std::shared_ptr<const std::vector<std::uint8_t>> raw;
+        unsigned int plugin_version = 0;
+    };
+
+    // A shard as Save sees it: its table, or its record if it was never decoded.
+    struct SavedShard {
+        RefID refid;
+        FavoritesTable data;  // shares its blocks with the live table
+        std::shared_ptr<const std::vector<std::uint8_t>> raw;
+        unsigned int plugin_version;
+    };
+    struct Snapshot {
+        std::vector<SavedShard> shards;
+        std::shared_ptr<const FormIDRemap> remap;
+    };
+    using Lock = std::mutex;
+    using Locker = std::lock_guard<Lock>;
+
+    std::unordered_map<RefID, Shard> shards;
+    std::vector<RefID> dirty;  // shards with pending items
+    // items queued by the container sink, handed to the shards by Drain on the game thread
+    std::vector<std::pair<RefID, FormID>> queued_items;
+    std::vector<std::pair<RefID, FormID>> drained_items;  // swapped with queued_items by Drain
+    std::unordered_set<RefID> tracked;  // the keys of shards, for QueueItem
+    mutable Lock queue_lock;
+    std::shared_ptr<const FormIDRemap> remap;  // load order of the save the undecoded shards came from
+
+    std::atomic<std::shared_ptr<const Snapshot>> published{std::make_shared<const Snapshot>()};
+    // bumped when shards come or go; with the sum of the shard revisions it tells whether Publish has work to do
+    std::uint64_t layout_revision = 0;
+    std::uint64_t published_layout = 0;
+    std::uint64_t published_revisions = 0;
+
+    // The shard of refid with its record decoded, nullptr if refid is not tracked.
+    Shard* Get(const RefID refid);
+
+    [[nodiscard]] static RE::TESObjectREFR* GetReference(const RefID refid);
+
+    // Adds the rows of a record to data, resolving them through remap.
+    static void Decode(const RefID refid, const std::vector<std::uint8_t>& bytes, const unsigned int plugin_version,
+                       const FormIDRemap* remap, FavoritesTable& data);
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+// Scratch memory for the temporaries of one event. Inside a Scope, containers built on Get() allocate from a
+// monotonic buffer that is dropped in one go when the outermost scope ends. A buffer that overflowed is regrown to
+// fit before the next event, up to a cap, so in steady state the handlers do not touch the heap at all. Once a run of
+// events fits the initial size again, a grown buffer shrinks back to it. Every thread has an arena of its own, made
+// the first time it opens a Scope, so scopes on different threads never share a buffer.
+namespace EventArena {
+
+    inline constexpr std::size_t initial_capacity = 64 * 1024;
+
+    // regrowing stops here; larger events spill the rest to the heap
+    inline constexpr std::size_t max_capacity = 4 * 1024 * 1024;
+
+    // events in a row that fit the initial capacity before a grown buffer is given back
+    inline constexpr unsigned int quiet_releases = 256;
+
+    // The calling thread's arena inside a Scope, the default heap resource outside one.
+    [[nodiscard]] std::pmr::memory_resource* Get();
+
+    // Opened by the event handlers; nested scopes share the outermost one's arena.
+    class Scope {
+    public:
+        Scope();
+
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // Bytes the calling thread's arena holds without going to the heap.
+    [[nodiscard]] std::size_t Capacity();
+};
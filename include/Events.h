@@ -13,8 +13,32 @@ class myEventSink : public RE::BSTEventSink<RE::MenuOpenCloseEvent>,
     myEventSink& operator=(myEventSink&&) = delete;
 
 
+    using Lock = std::mutex;
+    using Locker = std::lock_guard<Lock>;
+
     Manager* M = Manager::GetSingleton();
 
+    // requests raised by events this frame, drained once by a single task. The sinks run on whichever thread sent the
+    // event, so everything down to closed_reference is only touched under event_lock.
+    mutable Lock event_lock;
+    bool sync_requested = false;
+    bool full_sync_requested = false;  // walk every favorite, for changes the hooks did not see
+    bool restore_requested = false;
+    bool ui_update_requested = false;
+    bool drain_scheduled = false;
+    std::pmr::vector<FormID> pending_items;  // base objects that entered the player's inventory
+    std::pmr::vector<FormID> pending_spells;  // spells the player learned
+    // swapped with the pending ones by Drain, so neither gives up its capacity
+    std::pmr::vector<FormID> drained_items;
+    std::pmr::vector<FormID> drained_spells;
+    bool spell_check_requested = false;  // a learned spell the event did not name
+    RefID opened_reference = 0;  // whose inventory the container menu opened or closed on, if not the player's
+    RefID closed_reference = 0;
+
+    // Hotkey1..Hotkey8 user event names, filled on first use since UserEvents is not up at static init
+    std::array<RE::BSFixedString, 8> hotkey_events;
+    bool hotkey_events_ready = false;
+
     virtual RE::BSEventNotifyControl ProcessEvent(RE::InputEvent* const* evns, RE::BSTEventSource<RE::InputEvent*>*) override;
     virtual RE::BSEventNotifyControl ProcessEvent(const RE::TESContainerChangedEvent* event,
                                           RE::BSTEventSource<RE::TESContainerChangedEvent>*) override;
@@ -25,7 +49,17 @@ class myEventSink : public RE::BSTEventSink<RE::MenuOpenCloseEvent>,
     virtual RE::BSEventNotifyControl ProcessEvent(const RE::SpellsLearned::Event* a_event,
                                      RE::BSTEventSource<RE::SpellsLearned::Event>*) override;
 
-    inline bool IsHotkeyEvent(const RE::BSFixedString& event_name) const;
+    bool IsHotkeyEvent(const RE::BSFixedString& event_name);
+
+    // a_full walks every favorite even when the hooks report the changes
+    void RequestSync(const bool a_full = false);
+
+    void RequestRestore(const bool update_ui);
+
+    // Call with event_lock held.
+    void ScheduleDrain();
+
+    void Drain();
 
 public:
     static myEventSink* GetSingleton() {
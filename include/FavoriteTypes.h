@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+// Plain types shared by the table, the reconciler and its backends. Nothing here touches the game, so the reconciler
+// builds against a backend without RE or SKSE.
+using FormID = std::uint32_t;
+
+// One stack of an item, told apart from the other stacks of its base object by the fingerprint of its extra list.
+struct Instance {
+    FormID formid;
+    std::uint32_t fingerprint = 0;
+};
+
+// An inventory item or known spell as a backend reports it.
+struct FavoriteView {
+    FormID formid;
+    bool favorited;
+    int hotkey;  // -1 if none or not favorited
+    std::uint32_t instance;  // FavoritesTable::any_instance for spells and plain items
+};
@@ -0,0 +1,150 @@
+#pragma once
+#include "FavoriteTypes.h"
+
+// Favorites as parallel columns: sorted FormIDs, 4-bit packed hotkeys, interned editor IDs and the fingerprint of
+// the favorited instance. Rows are kept in blocks and strings in pages, both shared between copies and cloned on the
+// first write, so a copy costs one pointer per block and page and a write after it only clones what it touches.
+class FavoritesTable {
+public:
+    static constexpr std::uint8_t no_hotkey = 0xF;
+    static constexpr std::uint32_t any_instance = 0;
+
+    // One row of a batch. The editor ID only has to outlive the call.
+    struct Row {
+        FormID formid;
+        int hotkey = -1;
+        std::string_view editorid;
+        std::uint32_t instance = any_instance;
+    };
+
+    FavoritesTable();
+
+    // shares the blocks and pages; the string index is only rebuilt if the copy is written to
+    FavoritesTable(const FavoritesTable& other);
+
+    FavoritesTable& operator=(const FavoritesTable& other);
+
+    FavoritesTable(FavoritesTable&&) = default;
+
+    FavoritesTable& operator=(FavoritesTable&&) = default;
+
+    // Bumped by every change, so readers can tell whether a copy is stale.
+    [[nodiscard]] inline std::uint64_t Revision() const { return revision; };
+
+    [[nodiscard]] inline std::size_t Size() const { return block_ends.empty() ? 0 : block_ends.back(); };
+
+    [[nodiscard]] inline bool Empty() const { return blocks.empty(); };
+
+    [[nodiscard]] inline bool Contains(const FormID formid) const { return Find(formid).found; };
+
+    // String slots in use or released for reuse, the empty string included. Only grows when no released slot is left.
+    [[nodiscard]] inline std::size_t StringSlots() const { return n_strings; };
+
+    // Returns false if formid is already in the table.
+    bool Insert(const FormID formid, const int hotkey = -1, const std::string_view editorid = {},
+                const std::uint32_t instance = any_instance);
+
+    // Inserts a batch by merging it in once, instead of shifting the columns per row. Rows already in the table are
+    // skipped, as are repeats of a FormID after its first row. Returns the number of rows inserted.
+    std::size_t InsertRows(std::span<const Row> rows);
+
+    bool Erase(const FormID formid);
+
+    void Clear();
+
+    [[nodiscard]] const int GetHotkey(const FormID formid) const;
+
+    // Negative or out of range hotkeys clear the hotkey.
+    void SetHotkey(const FormID formid, const int hotkey);
+
+    // Valid until the next change to the table.
+    [[nodiscard]] const std::string& GetEditorID(const FormID formid) const;
+
+    void SetEditorID(const FormID formid, const std::string_view editorid);
+
+    // Fingerprint of the favorited instance among stacks of the same base object, any_instance for plain ones.
+    [[nodiscard]] const std::uint32_t GetInstance(const FormID formid) const;
+
+    void SetInstance(const FormID formid, const std::uint32_t instance);
+
+    // Row access for scans. Rows are sorted by FormID.
+    [[nodiscard]] FormID FormIDAt(const std::size_t row) const;
+
+    [[nodiscard]] const int HotkeyAt(const std::size_t row) const;
+
+    [[nodiscard]] const std::string& EditorIDAt(const std::size_t row) const;
+
+    [[nodiscard]] std::uint32_t InstanceAt(const std::size_t row) const;
+
+private:
+    // A block holds up to 2 * block_rows rows and is split once it grows past that.
+    static constexpr std::size_t block_rows = 256;
+    static constexpr std::size_t page_strings = 256;
+
+    struct Block {
+        std::vector<FormID> formids;
+        std::vector<std::uint8_t> hotkeys;  // two rows per byte, low nibble first
+        std::vector<std::uint32_t> editorids;  // index into the string pages
+        std::vector<std::uint32_t> instances;
+
+        [[nodiscard]] inline std::size_t Size() const { return formids.size(); };
+
+        [[nodiscard]] std::uint8_t GetNibble(const std::size_t row) const;
+
+        void SetNibble(const std::size_t row, const std::uint8_t value);
+
+        void Insert(const std::size_t row, const FormID formid, const std::uint8_t hotkey, const std::uint32_t editorid,
+                    const std::uint32_t instance);
+
+        void Erase(const std::size_t row);
+
+        // Appends the rows [first, last) of other.
+        void Append(const Block& other, const std::size_t first, const std::size_t last);
+    };
+    using Page = std::array<std::string, page_strings>;
+
+    struct Position {
+        std::size_t block = 0;
+        std::size_t row = 0;  // in the block
+        bool found = false;
+    };
+
+    std::vector<std::shared_ptr<Block>> blocks;
+    std::vector<std::size_t> block_ends;  // rows in the blocks up to and including each one
+
+    // interned strings; index 0 is the empty string
+    std::vector<std::shared_ptr<Page>> pages;
+    std::uint32_t n_strings = 1;
+
+    // Only needed to write. The index holds views into the pages, so cloning a page moves its entries over.
+    bool strings_indexed = true;
+    std::unordered_map<std::string_view, std::uint32_t> string_index;
+    std::vector<std::uint32_t> string_refs{0};  // rows per string; a string is released when its last row goes
+    std::vector<std::uint32_t> free_strings;  // released slots, reused before the pages grow
+
+    std::uint64_t revision = 0;
+
+    // Where formid is, or where it would be inserted.
+    [[nodiscard]] Position Find(const FormID formid) const;
+
+    [[nodiscard]] Position Locate(const std::size_t row) const;
+
+    [[nodiscard]] inline const std::string& StringAt(const std::uint32_t index) const {
+        return (*pages[index / page_strings])[index % page_strings];
+    };
+
+    // The block or page, cloned first if a copy of the table still shares it.
+    Block& MutableBlock(const std::size_t block);
+
+    Page& MutablePage(const std::size_t page);
+
+    // Recounts the rows of the blocks from block on.
+    void UpdateBlockEnds(const std::size_t block);
+
+    // Returns the index of str, taking a reference to it.
+    std::uint32_t Intern(const std::string_view str);
+
+    void ReleaseString(const std::uint32_t index);
+
+    void IndexStrings();
+};
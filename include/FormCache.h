@@ -0,0 +1,47 @@
+#pragma once
+#include "Utils.h"
+
+// Per-FormID metadata that is costly to query from the engine, filled on first lookup.
+// Reads are shared, so the save callback can use it off the game thread.
+class FormCache {
+public:
+    static FormCache* GetSingleton() {
+        static FormCache singleton;
+        return &singleton;
+    }
+
+    struct Entry {
+        std::uint32_t editorid = 0;  // index into strings
+        RE::FormType type = RE::FormType::None;
+        bool named = false;  // has a display name, i.e. can show up in the favorites menu
+    };
+
+    [[nodiscard]] Entry Get(const RE::TESForm* form);
+
+    // Entry of formid, looking the form up only if it is not cached. type is None if there is no such form.
+    [[nodiscard]] Entry Get(const FormID formid);
+
+    [[nodiscard]] const std::string& GetEditorID(const Entry& entry);
+
+    [[nodiscard]] const std::string& GetEditorID(const RE::TESForm* form);
+
+    [[nodiscard]] const std::string& GetEditorID(const FormID formid);
+
+    [[nodiscard]] inline bool HasName(const RE::TESForm* form) { return form && Get(form).named; };
+
+    [[nodiscard]] inline RE::FormType GetFormType(const RE::TESForm* form) { return Get(form).type; };
+
+    // Drops the entries of runtime-created forms, whose FormIDs get reused across saves.
+    void ClearDynamic();
+
+private:
+    FormCache() = default;
+    FormCache(const FormCache&) = delete;
+    FormCache& operator=(const FormCache&) = delete;
+
+    std::unordered_map<FormID, Entry> entries;
+    // deque keeps the strings in place, so the index can hold views into them
+    std::deque<std::string> strings{std::string()};
+    std::unordered_map<std::string_view, std::uint32_t> string_index;
+    std::shared_mutex lock;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include "Manager.h"
+
+namespace Hooks {
+
+    // A rel32 call to a hooked function: the function that makes it and the offset of the call in it, per runtime.
+    // The hooks are written at these sites with write_call, so the hooked functions stay untouched for other plugins.
+    // Sites are taken from a disassembly of each runtime, never searched for at run time: a byte pattern that merely
+    // looks like a call would get patched too.
+    struct CallSite {
+        REL::RelocationID caller;
+        REL::VariantOffset offset;
+    };
+
+    // Whether a_site is still a rel32 call to a_target. Checked for every site before anything is written, so a list
+    // that does not match the running game leaves its hook off instead of patching the wrong bytes.
+    [[nodiscard]] bool IsCallTo(const std::uintptr_t a_site, const std::uintptr_t a_target);
+
+    struct InventorySetFavorite {
+        static void thunk(RE::InventoryChanges* a_this, RE::InventoryEntryData* a_entry, RE::ExtraDataList* a_itemList);
+        static inline REL::Relocation<decltype(thunk)> func;
+        static inline const std::array<CallSite, 0> call_sites{};
+        static inline const auto id = RELOCATION_ID(15858, 16098);
+    };
+
+    struct InventoryRemoveFavorite {
+        static void thunk(RE::InventoryChanges* a_this, RE::InventoryEntryData* a_entry, RE::ExtraDataList* a_itemList);
+        static inline REL::Relocation<decltype(thunk)> func;
+        static inline const std::array<CallSite, 0> call_sites{};
+        static inline const auto id = RELOCATION_ID(15859, 16099);
+    };
+
+    struct MagicSetFavorite {
+        static void thunk(RE::MagicFavorites* a_this, RE::TESForm* a_form);
+        static inline REL::Relocation<decltype(thunk)> func;
+        static inline const std::array<CallSite, 0> call_sites{};
+        static inline const auto id = RELOCATION_ID(51121, 52004);
+    };
+
+    struct MagicRemoveFavorite {
+        static void thunk(RE::MagicFavorites* a_this, RE::TESForm* a_form);
+        static inline REL::Relocation<decltype(thunk)> func;
+        static inline const std::array<CallSite, 0> call_sites{};
+        static inline const auto id = RELOCATION_ID(51122, 52005);
+    };
+
+    struct ActorAddSpell {
+        static bool thunk(RE::Actor* a_this, RE::SpellItem* a_spell);
+        static inline REL::Relocation<decltype(thunk)> func;
+        static inline const std::array<CallSite, 0> call_sites{};
+        static inline const auto id = RELOCATION_ID(37771, 38716);
+    };
+
+    struct ActorRemoveSpell {
+        static bool thunk(RE::Actor* a_this, RE::SpellItem* a_spell);
+        static inline REL::Relocation<decltype(thunk)> func;
+        static inline const std::array<CallSite, 0> call_sites{};
+        static inline const auto id = RELOCATION_ID(37772, 38717);
+    };
+
+    // Enables the Manager features whose hooks were all installed. The favorite hooks only see the calls in their
+    // lists, not calls made through pointers or from other plugins, so the Manager still walks the favorites once a
+    // menu closes. A hook whose list is empty stays off and its group falls back to polling.
+    void Install();
+};
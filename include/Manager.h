@@ -1,40 +1,90 @@
 
 #pragma once
-#include "Serialization.h"
+#include "ActorShards.h"
 
 #define ENABLE_IF_NOT_UNINSTALLED if (isUninstalled) return;
 
-class Manager : public SaveLoadData, public RE::Actor::ForEachSpellVisitor {
-
-    std::set<FormID> favorites;
-    std::map<FormID, unsigned int> hotkey_map;
-    std::set<FormID> temp_all_spells;
+class Manager : public SaveLoadData {
+
+    using Lock = std::mutex;
+    using Locker = std::lock_guard<Lock>;
+
+    HotkeySlots hotkey_slots;
+    FormCache* form_cache = FormCache::GetSingleton();
+    SkyrimBackend backend;
+    Reconciler<SkyrimBackend> reconciler{backend, m_Data, hotkey_slots};
+    ActorShards actor_shards;
+
+    // favorite changes reported by the hooks, drained by SyncFavorites
+    struct FavoriteDelta {
+        FormID formid;
+        bool favorited;
+        int hotkey;
+        std::uint32_t instance;
+    };
+    std::vector<FavoriteDelta> pending_deltas;
+    std::vector<FavoriteDelta> applied_deltas;  // swapped with pending_deltas by ApplyDeltas
+    mutable Lock delta_lock;
+    bool delta_tracking = false;
+    std::uint64_t delta_revision = 0;  // deltas queued so far, under delta_lock
+    std::atomic<std::uint32_t> inventory_revision = 0;  // changes to the player's items and counts seen so far
+
+    // cosave records staged by ReceiveData, resolved a batch per frame after load or all at once when first needed
+    struct RestoreState {
+        bool pending = false;
+        bool scheduled = false;
+        bool collected = true;  // decoded rows and the profile are in the table; false from ReceiveData to CollectStaged
+        bool merge_profile = false;  // the save had no favorites record
+        std::size_t next_row = 0;
+        std::vector<FormID> unresolved;
+        std::vector<std::tuple<FormID, FormID, std::string>> moved;
+        int n_instances = 0;
+    } restore;
+    static constexpr std::size_t restore_batch = 64;
+
+    // StateFingerprint after the last AddFavorites pass, 0 if none ran since the last reset
+    std::uint64_t reconciled_fingerprint = 0;
 
     bool isUninstalled = false;
 
-    const std::set<unsigned int> allowed_hotkeys = {0,1,2,3,4,5,6,7};
-    
+    // id the character's profile is stored under; read from the cosave, made up on the first save without one
+    std::uint64_t profile_id = 0;
+
     const bool RemoveFavorite(const FormID formid);
 
+    [[nodiscard]] static inline std::string_view GetCharacterName() {
+        return RE::PlayerCharacter::GetSingleton()->GetName();
+    };
+
+    // Adds the favorites of this character's profile. Only for saves without a favorites record, so a save never picks
+    // up favorites of a later save of the same character.
+    void MergeProfile();
+
     const int GetHotkey(const RE::InventoryEntryData* a_entry) const ;
 
     const bool IsHotkeyValid(const int hotkey) const;
 
+    // Records the hotkey and the favorited instance of an inventory entry.
     void UpdateHotkeyMap(const FormID item_formid, const RE::InventoryEntryData* a_entry);
 
     void UpdateHotkeyMap(const FormID spell_formid, const int a_hotkey);
 
-    const std::map<unsigned int, FormID> GetInventoryHotkeys() const;
+    // in the event arena
+    const std::pmr::map<FormID, unsigned int> GetMagicHotkeys() const;
 
-    const std::map<FormID, unsigned int> GetMagicHotkeys() const;
-    
-    const std::map<unsigned int, FormID> GetHotkeysInUse() const;
+    // Current holder of each hotkey slot; item holders that lost their hotkey are released.
+    std::array<FormID, HotkeySlots::n_slots> SlotOwners();
 
-    const FormID HotkeyIsInUse(const FormID, const int a_hotkey) const;
+    // True if the game shows formid as a favorite. Spells are checked against the last mirror.
+    const bool HoldsFavorite(const FormID formid);
 
-    void HotkeySpell(RE::TESForm* form, const unsigned int hotkey);
+    // Puts hotkey on the item or spell without any conflict checks.
+    void WriteHotkey(const FormID formid, const unsigned int hotkey);
 
-    void ApplyHotkey(const FormID formid);
+    // Restores the saved hotkeys of a batch of favorites through SolveHotkeys, then writes only what changed.
+    void CommitHotkeys(std::span<const FormID> formids);
+
+    void HotkeySpell(RE::TESForm* form, const unsigned int hotkey);
 
     void SyncHotkeys_Item();
 
@@ -42,11 +92,26 @@ class Manager : public SaveLoadData, public RE::Actor::ForEachSpellVisitor {
 
     void SyncHotkeys();
 
+    void SyncHotkeys_Delta();
+
+    void ApplyDeltas();
+
     const bool IsSpellFavorited(const FormID a_spell,const RE::BSTArray<RE::TESForm*>& favs) const;
 
-    RE::BSContainer::ForEachResult Visit(RE::SpellItem* a_spell);
+    // Hash of everything AddFavorites reads: the player's inventory with counts and favorite and hotkey extras, the
+    // MagicFavorites arrays, the player spell count and the table revision. With delta tracking the inventory part is
+    // the delta and inventory revisions, so it costs nothing per item; without it the entry list is walked.
+    [[nodiscard]] std::uint64_t StateFingerprint();
 
-    void CollectPlayerSpells();
+    // Takes the rows decoded off-thread, or the character profile if the save had none, into the table, once per load.
+    void CollectStaged();
+
+    // Returns true once every staged row has been resolved.
+    const bool ResolveStaged(const std::size_t max_rows);
+
+    void FinishRestore();
+
+    void RestoreStep();
 
 public:
     static Manager* GetSingleton() {
@@ -60,26 +125,122 @@ public:
     
     void AddFavorites_Spell();
 
-    void AddFavorites();
+    // Returns false without doing anything if nothing changed since the last pass.
+    bool AddFavorites();
 
     void SyncFavorites_Item();
 
     void SyncFavorites_Spell();
 
-    void SyncFavorites();
+    // Records what the player changed. With delta tracking only the hooked changes are applied, unless a_full asks
+    // for the walk over every item and spell.
+    void SyncFavorites(const bool a_full = false);
 
     void FavoriteCheck_Item(const FormID formid);
 
+    // Puts the saved hotkey of formid back on the item or spell, if it is free.
+    void ApplyHotkey(const FormID formid);
+
+    // Restores favorites and hotkeys for a batch of items that entered the player's inventory.
+    void FavoriteCheck_Items(std::pmr::vector<FormID>& formids);
+
     void FavoriteCheck_Spell(const FormID formid);
 
+    // Restores favorites and hotkeys for a batch of newly learned spells only.
+    void FavoriteCheck_Spells(std::pmr::vector<FormID>& formids);
+
     void FavoriteCheck_Spell();
+
+    // Remembers the favorites of a follower, mannequin or container from now on.
+    void TrackReference(const RefID refid);
+
+    void UntrackReference(const RefID refid);
+
+    // Queues an item that entered a reference other than the player. Returns false if the reference is not tracked.
+    inline bool QueueReferenceItem(const RefID refid, const FormID formid) {
+        return !isUninstalled && actor_shards.QueueItem(refid, formid);
+    };
+
+    // Restores the favorites of the items queued for tracked references.
+    void FavoriteCheck_References();
+
+    // Favorites the saved items of refid again. Followers are tracked the first time their inventory is opened.
+    void AddFavorites_Reference(const RefID refid);
+
+    void SyncFavorites_Reference(const RefID refid);
+
+    [[nodiscard]] inline bool QueueReferenceRecord(SKSE::SerializationInterface* serializationInterface,
+                                                   unsigned int plugin_version, std::uint32_t length) {
+        return actor_shards.QueueRecord(serializationInterface, plugin_version, length);
+    };
+
+    inline void FinishReferenceLoad(SKSE::SerializationInterface* serializationInterface) {
+        actor_shards.FinishLoad(serializationInterface);
+    };
+
+    // Stops tracking references that are gone and publishes the rest for SaveReferences.
+    inline void PruneReferences() {
+        actor_shards.Prune();
+        actor_shards.Publish();
+    };
+
+    // Writes the tracked references as last published.
+    [[nodiscard]] inline bool SaveReferences(SKSE::SerializationInterface* serializationInterface) const {
+        return actor_shards.Save(serializationInterface, Settings::kActorKey, Settings::kSerializationVersion);
+    };
+
+    // Publishes the player's table and the tracked references.
+    inline void Publish() {
+        SaveLoadData::Publish();
+        actor_shards.Publish();
+    };
+
+    inline void EnableDeltaTracking() { delta_tracking = true; };
+
+    // For container changes of the player, which add or drop items or change their counts. Safe from any thread.
+    inline void NoteInventoryChange() { inventory_revision.fetch_add(1, std::memory_order_relaxed); };
+
+    [[nodiscard]] inline bool IsDeltaTracking() const { return delta_tracking; };
+
+    inline void EnableSpellCache() { backend.EnableSpellCache(); };
+
+    inline void InvalidatePlayerSpells() { backend.InvalidatePlayerSpells(); };
+
+    // a_itemList is the extra list the game just favorited, if known
+    void QueueDelta(const RE::InventoryEntryData* a_entry, const RE::ExtraDataList* a_itemList = nullptr);
+
+    void QueueDelta(const RE::TESForm* a_spell);
     
     inline void Uninstall() { isUninstalled = true; };
 
     void Reset();
 
+    // Writes the character's profile from the published snapshot. Skipped while a restore is pending, since the
+    // table does not hold the saved favorites yet.
     void SendData();
 
-    void ReceiveData();
+    // a_cosave_found is false for saves without a favorites record, which take the character's profile instead
+    void ReceiveData(const bool a_cosave_found);
+
+    // Id of the current character's profile, made up on first use if the save did not carry one.
+    [[nodiscard]] std::uint64_t GetProfileID();
+
+    // Forgets the profile id, for a new character.
+    inline void ResetProfileID() { profile_id = 0; };
+
+    [[nodiscard]] bool SaveProfileID(SKSE::SerializationInterface* serializationInterface);
+
+    [[nodiscard]] bool LoadProfileID(SKSE::SerializationInterface* serializationInterface, std::uint32_t length);
+
+    void ScheduleRestore();
+
+    void EnsureRestored();
+
+    // Joins the decode, finishes a pending restore and publishes, so a reader of the snapshot sees every saved
+    // favorite. For callers outside a pass, like the save callback and the Papyrus natives.
+    void CompleteRestore();
+
+    // favorites count and the handler latency stats, after CompleteRestore
+    void DumpToLog() override;
 
 };
\ No newline at end of file
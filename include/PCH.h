@@ -1,8 +1,31 @@
 #include "RE/Skyrim.h"
 #include "SKSE/SKSE.h"
+#include <future>
+#include <memory_resource>
+#include <random>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
 namespace logger = SKSE::log;
+
+// Trace and debug calls below LOG_ACTIVE_LEVEL are compiled out together with their arguments.
+#ifndef LOG_ACTIVE_LEVEL
+    #ifdef NDEBUG
+        #define LOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+    #else
+        #define LOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+    #endif
+#endif
+#if LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+    #define LOG_TRACE(...) logger::trace(__VA_ARGS__)
+#else
+    #define LOG_TRACE(...) (void)0
+#endif
+#if LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+    #define LOG_DEBUG(...) logger::debug(__VA_ARGS__)
+#else
+    #define LOG_DEBUG(...) (void)0
+#endif
 using namespace std::literals;
 
 using FormID = RE::FormID;
@@ -0,0 +1,22 @@
+#pragma once
+#include "Manager.h"
+
+// Script natives, declared in Source/Scripts/PersistentFavorites.psc.
+namespace Papyrus {
+
+    constexpr auto script_name = "PersistentFavorites"sv;
+
+    // Latency stats per handler, one line each.
+    RE::BSFixedString GetStats(RE::StaticFunctionTag*);
+
+    void DumpStats(RE::StaticFunctionTag*);
+
+    void ResetStats(RE::StaticFunctionTag*);
+
+    // Remembers the favorites of a follower, mannequin or container and restores them when items come back to it.
+    void TrackReference(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref);
+
+    void UntrackReference(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref);
+
+    bool Register(RE::BSScript::IVirtualMachine* vm);
+};
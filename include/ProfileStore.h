@@ -0,0 +1,99 @@
+#pragma once
+#include "FavoritesTable.h"
+#include "Utils.h"
+
+// Favorites per character, kept in a fixed-layout file that is mapped into memory and shared by every save of that
+// character. Profiles are keyed by an id the cosave carries, since names repeat across characters. Rows are read
+// straight from the mapping; writes only touch rows that changed and flush their pages.
+class ProfileStore {
+public:
+    static constexpr std::uint32_t magic = Utils::EncodeTypeCode("PFVP");
+    static constexpr std::uint32_t layout_version = 2;
+    static constexpr std::uint32_t n_profiles = 16;
+    static constexpr std::uint32_t rows_per_profile = 4096;
+    static constexpr std::size_t editorid_size = 58;
+
+    struct Row {
+        FormID formid;
+        std::uint8_t hotkey;  // FavoritesTable::no_hotkey if none
+        std::uint8_t editorid_length;  // 0 if the editor ID did not fit
+        char editorid[editorid_size];
+    };
+    static_assert(sizeof(Row) == 64);
+
+    struct Profile {
+        std::uint64_t key;  // character id from the cosave, 0 if the slot is free
+        std::uint32_t n_rows;
+        std::uint32_t generation;  // last write, used to evict the stalest profile when all slots are taken
+        char name[48];
+    };
+    static_assert(sizeof(Profile) == 64);
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t n_profiles;
+        std::uint32_t rows_per_profile;
+        std::uint32_t generation;
+        std::uint8_t reserved[44];
+    };
+    static_assert(sizeof(Header) == 64);
+
+    static constexpr std::size_t file_size =
+        sizeof(Header) + n_profiles * sizeof(Profile) + std::size_t{n_profiles} * rows_per_profile * sizeof(Row);
+
+    static ProfileStore* GetSingleton() {
+        static ProfileStore singleton;
+        return &singleton;
+    }
+
+    // Maps the store, creating or resetting the file if it is missing or has another layout.
+    bool Open(const std::filesystem::path& path);
+
+    void Close();
+
+    [[nodiscard]] inline bool IsOpen() const { return view != nullptr; };
+
+    // Rows of the profile of character a_id, valid until the next Write or Close. Empty if there is none.
+    [[nodiscard]] std::span<const Row> Read(std::uint64_t a_id) const;
+
+    // Stores data as the profile of character a_id, named a_character in the log. Rows past rows_per_profile are
+    // dropped with a warning.
+    bool Write(std::uint64_t a_id, std::string_view a_character, const FavoritesTable& data);
+
+    [[nodiscard]] static inline std::string_view EditorID(const Row& row) {
+        return {row.editorid, std::min<std::size_t>(row.editorid_length, editorid_size)};
+    };
+
+private:
+    ProfileStore() = default;
+    ProfileStore(const ProfileStore&) = delete;
+    ProfileStore& operator=(const ProfileStore&) = delete;
+    ~ProfileStore() { Close(); };
+
+    std::uint8_t* view = nullptr;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    [[nodiscard]] inline Header* GetHeader() const { return reinterpret_cast<Header*>(view); };
+
+    [[nodiscard]] inline Profile* GetProfile(const std::uint32_t slot) const {
+        return reinterpret_cast<Profile*>(view + sizeof(Header)) + slot;
+    };
+
+    [[nodiscard]] inline Row* GetRows(const std::uint32_t slot) const {
+        return reinterpret_cast<Row*>(view + sizeof(Header) + n_profiles * sizeof(Profile)) +
+               std::size_t{slot} * rows_per_profile;
+    };
+
+    [[nodiscard]] std::int64_t FindSlot(const std::uint64_t key) const;
+
+    // slot of key, or the free or stalest slot claimed for it
+    [[nodiscard]] std::uint32_t AcquireSlot(const std::uint64_t key, std::string_view a_character);
+
+    void Flush(const std::uint8_t* begin, const std::uint8_t* end) const;
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include "EventArena.h"
+#include "FavoritesTable.h"
+
+// Which form currently holds each of the 8 favorites hotkeys, items and spells alike.
+class HotkeySlots {
+public:
+    static constexpr unsigned int n_slots = 8;
+
+    inline const FormID Owner(const unsigned int slot) const { return slot < n_slots ? owners[slot] : 0; };
+
+    const int SlotOf(const FormID formid) const;
+
+    // Moves formid to slot, evicting the previous owner of slot.
+    void Assign(const FormID formid, const unsigned int slot);
+
+    void Release(const FormID formid);
+
+    inline void Clear() { owners.fill(0); };
+
+private:
+    std::array<FormID, n_slots> owners{};
+};
+
+// Outcome of one batch of hotkey restores, allocated like the batch it was solved from.
+struct HotkeyPlan {
+    std::pmr::vector<std::pair<FormID, unsigned int>> writes;  // slots to put on forms that do not hold them yet
+    std::pmr::vector<std::pair<FormID, unsigned int>> denied;  // forms that lose their saved slot to its current owner
+};
+
+// Resolves the wanted form -> slot assignments of a batch against the slot owners in one pass. A slot stays with its
+// current owner; of several forms wanting a free slot the lowest FormID gets it, so the outcome does not depend on the
+// order favorites were restored in. Forms that already hold their slot need no write.
+[[nodiscard]] HotkeyPlan SolveHotkeys(std::pmr::vector<std::pair<FormID, unsigned int>> wanted,
+                                      const std::array<FormID, HotkeySlots::n_slots>& owners);
+
+// The passes that reconcile the game's favorites with the table, written against a backend policy instead of the
+// game. A backend provides
+//   void ForEachItem(F)                             the named items in the player's inventory, as FavoriteViews
+//   std::size_t ForEachSpell(F)                     the player's known spells, returns how many there are
+//   std::size_t FavoriteItems(std::span<const Instance>)
+//   void FavoriteSpell(FormID)
+//   std::string GetEditorID(FormID)
+// All calls are resolved at compile time, so a backend costs nothing over calling the game directly. The passes do not
+// log, so they build without the plugin's log setup; backends log what they see.
+template <class Backend>
+class Reconciler {
+public:
+    using Instance = ::Instance;
+
+    Reconciler(Backend& a_backend, FavoritesTable& a_data, HotkeySlots& a_slots)
+        : backend(a_backend), data(a_data), slots(a_slots) {}
+
+    // Records favorited items and their hotkeys. With a_erase, items the player unfavorited are dropped.
+    void RecordItems(const bool a_erase) {
+        std::pmr::vector<FavoriteView> added(EventArena::Get());
+        backend.ForEachItem([this, a_erase, &added](const FavoriteView& item) {
+            if (item.favorited) Record(item, added);
+            else if (a_erase) Erase(item.formid);
+        });
+        Insert(added);
+    }
+
+    void RecordSpells(const bool a_erase) {
+        std::pmr::vector<FavoriteView> added(EventArena::Get());
+        backend.ForEachSpell([this, a_erase, &added](const FavoriteView& spell) {
+            if (spell.favorited) Record(spell, added);
+            else if (a_erase) Erase(spell.formid);
+        });
+        Insert(added);
+    }
+
+    // Records favorited items and favorites the saved ones the game lost again. Returns the restored FormIDs, whose
+    // hotkeys still need to be applied, in the event arena.
+    std::pmr::vector<FormID> RestoreItems() {
+        std::pmr::vector<Instance> to_restore(EventArena::Get());
+        std::pmr::vector<FavoriteView> added(EventArena::Get());
+        backend.ForEachItem([this, &to_restore, &added](const FavoriteView& item) {
+            if (item.favorited) Record(item, added);
+            else if (data.Contains(item.formid)) to_restore.push_back({item.formid, data.GetInstance(item.formid)});
+        });
+        Insert(added);
+        // favoriting invalidates the inventory; restore all first so the hotkeys share one rebuilt snapshot
+        backend.FavoriteItems(to_restore);
+        std::pmr::vector<FormID> restored(EventArena::Get());
+        restored.reserve(to_restore.size());
+        for (const auto& instance : to_restore) restored.push_back(instance.formid);
+        return restored;
+    }
+
+    std::pmr::vector<FormID> RestoreSpells() {
+        std::pmr::vector<FormID> restored(EventArena::Get());
+        std::pmr::vector<FavoriteView> added(EventArena::Get());
+        backend.ForEachSpell([this, &restored, &added](const FavoriteView& spell) {
+            if (spell.favorited) Record(spell, added);
+            else if (data.Contains(spell.formid)) restored.push_back(spell.formid);
+        });
+        Insert(added);
+        for (const auto formid : restored) backend.FavoriteSpell(formid);
+        return restored;
+    }
+
+    void RecordHotkey(const FormID formid, const int hotkey) {
+        if (hotkey < 0 || hotkey >= static_cast<int>(HotkeySlots::n_slots)) return;
+        data.SetHotkey(formid, hotkey);
+        slots.Assign(formid, hotkey);
+    }
+
+    bool Erase(const FormID formid) {
+        const auto removed = data.Erase(formid);
+        slots.Release(formid);
+        return removed;
+    }
+
+private:
+    Backend& backend;
+    FavoritesTable& data;
+    HotkeySlots& slots;
+
+    // Favorites not in the table yet are collected in a_added, for Insert to add in one batch after the pass.
+    void Record(const FavoriteView& a_view, std::pmr::vector<FavoriteView>& a_added) {
+        if (!data.Contains(a_view.formid)) {
+            a_added.push_back(a_view);
+            return;
+        }
+        data.SetInstance(a_view.formid, a_view.instance);
+        RecordHotkey(a_view.formid, a_view.hotkey);
+    }
+
+    void Insert(const std::pmr::vector<FavoriteView>& a_added) {
+        if (a_added.empty()) return;
+        // editor IDs are only looked up for new rows; reserved, so the rows can view them
+        std::pmr::vector<std::string> editorids(EventArena::Get());
+        std::pmr::vector<FavoritesTable::Row> rows(EventArena::Get());
+        editorids.reserve(a_added.size());
+        rows.reserve(a_added.size());
+        for (const auto& view : a_added) {
+            const auto& editorid = editorids.emplace_back(backend.GetEditorID(view.formid));
+            rows.push_back({view.formid, -1, editorid, view.instance});
+        }
+        data.InsertRows(rows);
+        for (const auto& view : a_added) RecordHotkey(view.formid, view.hotkey);
+    }
+};
@@ -1,51 +1,142 @@
 
 
 #pragma once
+#include "FavoritesTable.h"
+#include "FormCache.h"
+#include "ProfileStore.h"
 #include "Settings.h"
+#include "Stats.h"
 
 
-using SaveDataLHS = std::pair<RE::FormID, std::string>;
 using SaveDataRHS = int;
 
+// Load order of the save being loaded, captured in the load callback so saved FormIDs can still be resolved once the
+// serialization interface is gone.
+class FormIDRemap {
+public:
+    // One ResolveFormID call per full and light plugin index.
+    void Capture(SKSE::SerializationInterface* serializationInterface);
+
+    [[nodiscard]] bool Resolve(const FormID saved, FormID& resolved) const;
+
+    // True if every plugin of the save that is still loaded kept its index and no new plugin took the index of one
+    // that is gone, so saved FormIDs need no change.
+    [[nodiscard]] inline bool IsIdentity() const { return identity; };
+
+private:
+    static constexpr FormID unresolved = 0xFFFFFFFF;
+    bool identity = true;
+    std::array<FormID, 0xFE> full{};  // resolved upper byte, per saved plugin index
+    std::array<FormID, 0x1000> light{};  // resolved upper 20 bits, per saved light plugin index
+};
+
 
 // github.com/ozooma10/OSLAroused/blob/29ac62f220fadc63c829f6933e04be429d4f96b0/src/PersistedData.cpp
-template <typename T, typename U>
+template <typename T>
 // BaseData is based off how powerof3's did it in Afterlife
 class BaseData {
 public:
 
-    void SetData(T formId, U value);
-
     virtual const char* GetType() = 0;
 
     virtual bool Save(SKSE::SerializationInterface*, std::uint32_t, std::uint32_t) { return false; };
     virtual bool Save(SKSE::SerializationInterface*) { return false; };
-    virtual bool Load(SKSE::SerializationInterface*, unsigned int) { return false; };
+    virtual bool Load(SKSE::SerializationInterface*, unsigned int, std::uint32_t) { return false; };
 
     void Clear();
 
     virtual void DumpToLog() = 0;
 
+    using Snapshot = std::shared_ptr<const T>;
+
+    // Last published copy of m_Data. Safe to read from any thread; it never changes once published.
+    [[nodiscard]] Snapshot GetSnapshot() const { return m_Published.load(std::memory_order_acquire); };
+
+    // Only the game thread writes m_Data and publishes it, after each pass that may have changed it. The copy shares
+    // the storage of the table, so a publish only pays for what changed since the last one.
+    void Publish() {
+        if (m_Data.Revision() == m_PublishedRevision) return;
+        m_PublishedRevision = m_Data.Revision();
+        m_Published.store(std::make_shared<const T>(m_Data), std::memory_order_release);
+    };
+
 protected:
-    std::map<T, U> m_Data;
+    T m_Data;
 
-    using Lock = std::recursive_mutex;
-    using Locker = std::lock_guard<Lock>;
-    mutable Lock m_Lock;
+private:
+    std::atomic<Snapshot> m_Published{std::make_shared<const T>()};
+    std::uint64_t m_PublishedRevision = 0;
 };
 
-class SaveLoadData : public BaseData<SaveDataLHS, SaveDataRHS> {
+class SaveLoadData : public BaseData<FavoritesTable> {
 public:
-    void DumpToLog() override {
-        // nothing for now
-    }
+    // One favorite as stored in the cosave, with its FormID already resolved to the current load order.
+    struct SavedRow {
+        FormID formid;
+        int hotkey;
+        std::string editorid;
+        std::uint32_t instance;
+    };
+
+    using Resolver = std::function<bool(FormID&)>;
+
+    // favorites count and the handler latency stats
+    void DumpToLog() override;
 
     [[nodiscard]] bool Save(SKSE::SerializationInterface* serializationInterface) override;
 
     [[nodiscard]] bool Save(SKSE::SerializationInterface* serializationInterface, std::uint32_t type,
                             std::uint32_t version) override;
 
-    [[nodiscard]] bool Load(SKSE::SerializationInterface* serializationInterface, unsigned int plugin_version) override;
+    // Copies a record out of the interface without decoding it. Returns false if it could not be read.
+    [[nodiscard]] bool QueueRecord(SKSE::SerializationInterface* serializationInterface, unsigned int plugin_version,
+                                   std::uint32_t length);
+
+    // Hands the queued records to a worker thread that decodes and resolves them while the game finishes loading.
+    void StartDecode(SKSE::SerializationInterface* serializationInterface);
+
+    // Adds the decoded rows to the table, waiting for the worker if it is not done. False if nothing was decoding.
+    bool FinishDecode();
+
+    // Drops queued records and waits out a decode still running.
+    void DiscardDecode();
+
+    // Decodes one record of any version. Thread-safe; only touches its arguments.
+    [[nodiscard]] static bool Decode(Utils::RecordReader& reader, unsigned int plugin_version, const Resolver& resolve,
+                                     std::vector<SavedRow>& rows);
+
+    // Adds decoded rows to data in one batch. Returns the number inserted; repeated FormIDs are logged and dropped.
+    static std::size_t InsertRows(FavoritesTable& data, const std::vector<SavedRow>& rows);
+
+    // Rows of data worth saving, each with its editor ID if the table has none.
+    [[nodiscard]] static std::vector<std::pair<std::size_t, std::string>> SaveableRows(const FavoritesTable& data);
+
+    // Writes rows [first, last) as the body of one chunk.
+    static void WriteRows(Utils::RecordWriter& writer, const FavoritesTable& data,
+                          const std::vector<std::pair<std::size_t, std::string>>& rows, const std::size_t first,
+                          const std::size_t last);
+
+private:
+    struct QueuedRecord {
+        unsigned int plugin_version;
+        std::vector<std::uint8_t> bytes;
+    };
+    std::vector<QueuedRecord> queued_records;
+    std::future<std::vector<SavedRow>> decoding;
+
+    // versions 1 and 2: fixed-width fields and per-char editor IDs
+    [[nodiscard]] static bool DecodeLegacy(Utils::RecordReader& reader, unsigned int plugin_version,
+                                           const Resolver& resolve, std::vector<SavedRow>& rows);
+
+    // version 3: one record per chunk of Settings::chunk_size rows, each a varint chunk index and chunk count followed
+    // by the rows
+    [[nodiscard]] static bool DecodeChunk(Utils::RecordReader& reader, const Resolver& resolve,
+                                          std::vector<SavedRow>& rows);
+
+    // varint count, then per record a varint FormID delta, a length-prefixed editor ID, a hotkey byte and a varint
+    // instance fingerprint
+    [[nodiscard]] static bool DecodeRows(Utils::RecordReader& reader, const Resolver& resolve,
+                                         std::vector<SavedRow>& rows);
 
 };
 
@@ -3,12 +3,22 @@
 #include "Utils.h"
 
 namespace Settings {
-    constexpr std::uint32_t kSerializationVersion = 35;
-    constexpr std::uint32_t kDataKey = 'STFV';
+    constexpr std::uint32_t kSerializationVersion = 36;
+    constexpr std::uint32_t kDataKey = Utils::EncodeTypeCode("STFV");
+    // one record per tracked reference other than the player
+    constexpr std::uint32_t kActorKey = Utils::EncodeTypeCode("STFA");
+    // the id the character's profile is stored under
+    constexpr std::uint32_t kProfileKey = Utils::EncodeTypeCode("STFP");
     static const std::map<std::uint32_t, unsigned int> version_map = {
         {34,1}, 
-        {kSerializationVersion, 2}
+        {35,2},
+        {kSerializationVersion, 3}
     };
 
-    static const unsigned int instance_limit = 1000;
+    // favorites per cosave record; larger tables are split across several records
+    static const unsigned int chunk_size = 1000;
+
+    // favorites per character shared across saves; skipped if the file can not be mapped
+    constexpr bool use_profile_store = true;
+    constexpr auto profile_store_path = "Data/SKSE/Plugins/PersistentFavorites_Profiles.bin";
 };
\ No newline at end of file
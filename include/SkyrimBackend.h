@@ -0,0 +1,86 @@
+#pragma once
+#include "FormCache.h"
+#include "Reconciler.h"
+
+// Reconciler backend over the live game: the player's inventory snapshot, known spells and MagicFavorites.
+class SkyrimBackend : public RE::Actor::ForEachSpellVisitor {
+public:
+    using Instance = Utils::FunctionsSkyrim::Inventory::Instance;
+
+    template <class F>
+    void ForEachItem(F&& a_visit) {
+        ForEachItem(RE::PlayerCharacter::GetSingleton(), std::forward<F>(a_visit));
+    }
+
+    // The named items of any reference's inventory, as FavoriteViews.
+    template <class F>
+    static void ForEachItem(RE::TESObjectREFR* a_owner, F&& a_visit) {
+        using namespace Utils::FunctionsSkyrim::Inventory;
+        const auto inventory = GetSnapshot(a_owner);
+        const auto form_cache = FormCache::GetSingleton();
+        for (const auto& [item, data] : *inventory) {
+            const auto& [count, entry] = data;
+            if (!item || count <= 0) continue;
+            if (!form_cache->HasName(item)) continue;
+            if (!entry) continue;
+            const auto favorited = entry->IsFavorited();
+            const auto xList = favorited ? GetFavoritedList(entry.get()) : nullptr;
+            a_visit(FavoriteView{item->GetFormID(), favorited, GetHotkey(xList), GetInstanceFingerprint(xList)});
+        }
+    }
+
+    template <class F>
+    std::size_t ForEachSpell(F&& a_visit) {
+        const auto& all_spells = GetPlayerSpells();
+        if (all_spells.empty()) logger::warn("ForEachSpell: No spells found.");
+        MirrorFavoritedSpells();
+        const auto& mg_hotkeys = RE::MagicFavorites::GetSingleton()->hotkeys;
+        for (const auto spell_formid : all_spells) {
+            if (!Utils::FunctionsSkyrim::GetFormByID(spell_formid)) continue;
+            const auto favorited = IsSpellFavorited(spell_formid);
+            int hotkey = -1;
+            if (favorited) {
+                int index = 0;
+                for (const auto* hotkeyed_spell : mg_hotkeys) {
+                    if (hotkeyed_spell && hotkeyed_spell->GetFormID() == spell_formid) {
+                        hotkey = index;
+                        break;
+                    }
+                    index++;
+                }
+            }
+            a_visit(FavoriteView{spell_formid, favorited, hotkey, FavoritesTable::any_instance});
+        }
+        return all_spells.size();
+    }
+
+    std::size_t FavoriteItems(std::span<const Instance> instances);
+
+    void FavoriteSpell(const FormID formid);
+
+    [[nodiscard]] inline std::string GetEditorID(const FormID formid) { return form_cache->GetEditorID(formid); };
+
+    // player spells, kept until the hooks report a spell being added or removed
+    const std::unordered_set<FormID>& GetPlayerSpells();
+
+    inline void EnableSpellCache() { spell_cache = true; };
+
+    inline void InvalidatePlayerSpells() { player_spells_valid = false; };
+
+    // hashed copy of MagicFavorites::spells, refreshed once per pass
+    void MirrorFavoritedSpells();
+
+    [[nodiscard]] inline bool IsSpellFavorited(const FormID a_spell) const { return favorited_spells.contains(a_spell); };
+
+    // hotkey of a favorited extra list, -1 if it has none
+    [[nodiscard]] static int GetHotkey(const RE::ExtraDataList* xList);
+
+private:
+    FormCache* form_cache = FormCache::GetSingleton();
+    std::unordered_set<FormID> player_spells;
+    std::atomic_bool player_spells_valid = false;
+    bool spell_cache = false;
+    std::unordered_set<FormID> favorited_spells;
+
+    RE::BSContainer::ForEachResult Visit(RE::SpellItem* a_spell) override;
+};
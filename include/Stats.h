@@ -0,0 +1,82 @@
+#pragma once
+
+// Latency histograms for the event handlers and callbacks, cheap enough to stay on in release builds.
+namespace Stats {
+
+    enum class Probe : std::uint8_t {
+        kInput,
+        kMenu,
+        kContainer,
+        kSpellsLearned,
+        kDrain,
+        kAddFavorites,
+        kSyncFavorites,
+        kSyncHotkeys,
+        kRestore,
+        kSave,
+        kLoad,
+        kDecode,
+        kTotal
+    };
+
+    // Log-linear buckets in microseconds: exact below 8 us, then 8 per power of two (HDR-style, <= 12.5% error) up
+    // to ~2 minutes. Safe to record from any thread.
+    class Histogram {
+    public:
+        static constexpr unsigned int sub_bits = 3;
+        static constexpr unsigned int n_sub = 1 << sub_bits;
+        static constexpr unsigned int n_octaves = 25;
+        static constexpr unsigned int n_buckets = n_octaves * n_sub;
+
+        void Record(const std::uint64_t us, const std::uint64_t n_items);
+
+        void Reset();
+
+        [[nodiscard]] std::uint64_t Count() const { return count.load(std::memory_order_relaxed); };
+
+        [[nodiscard]] std::uint64_t Max() const { return max_us.load(std::memory_order_relaxed); };
+
+        [[nodiscard]] std::uint64_t Items() const { return items.load(std::memory_order_relaxed); };
+
+        // Upper bound of the bucket holding the p-th fraction of the samples.
+        [[nodiscard]] std::uint64_t Percentile(const double p) const;
+
+    private:
+        std::array<std::atomic<std::uint32_t>, n_buckets> buckets{};
+        std::atomic<std::uint64_t> count = 0;
+        std::atomic<std::uint64_t> max_us = 0;
+        std::atomic<std::uint64_t> items = 0;
+
+        [[nodiscard]] static unsigned int BucketOf(const std::uint64_t us);
+
+        [[nodiscard]] static std::uint64_t LowerBound(const unsigned int bucket);
+    };
+
+    Histogram& Get(const Probe probe);
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const Probe a_probe, const std::size_t a_items = 0)
+            : probe(a_probe), n_items(a_items), start(std::chrono::steady_clock::now()) {}
+
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        // items handled by the pass, if only known once it is done
+        inline void SetItems(const std::size_t a_items) { n_items = a_items; };
+
+    private:
+        Probe probe;
+        std::size_t n_items;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // One line per probe that has samples.
+    [[nodiscard]] std::string Summary();
+
+    void DumpToLog();
+
+    void Reset();
+};
@@ -2,6 +2,7 @@
 #pragma once
 #include <windows.h>
 #include <ClibUtil/editorID.hpp>
+#include "FavoriteTypes.h"
 
 namespace Utils {
     const auto mod_name = static_cast<std::string>(SKSE::PluginDeclaration::GetSingleton()->GetName());
@@ -14,6 +15,13 @@ namespace Utils {
 
     std::string DecodeTypeCode(std::uint32_t typeCode);
 
+    // Type code of four characters, the value the multi-character literal 'ABCD' has, without the warning.
+    constexpr std::uint32_t EncodeTypeCode(const char (&a_code)[5]) {
+        return std::uint32_t{static_cast<std::uint8_t>(a_code[0])} << 24 |
+               std::uint32_t{static_cast<std::uint8_t>(a_code[1])} << 16 |
+               std::uint32_t{static_cast<std::uint8_t>(a_code[2])} << 8 | static_cast<std::uint8_t>(a_code[3]);
+    }
+
     std::string GetPluginVersion(const unsigned int n_stellen);
 
 
@@ -61,10 +69,67 @@ namespace Utils {
             void OpenMenu(const std::string_view menuname);
             
             void CloseMenu(const std::string_view menuname);
+
+            // Reference whose inventory the container menu shows, 0 if none.
+            const RefID GetContainerMenuTarget();
         };
 
         namespace Inventory {
 
+            using Snapshot = std::shared_ptr<const RE::TESObjectREFR::InventoryItemMap>;
+
+            // Inventory of a_owner, built once and shared until the snapshot is invalidated. Holders keep their copy
+            // alive across invalidation, so it is safe to mutate the inventory while iterating a snapshot.
+            Snapshot GetSnapshot(RE::TESObjectREFR* inventory_owner);
+
+            // Must be called after anything that adds or removes entries or extra lists.
+            void InvalidateSnapshot();
+
+            const std::uint32_t GetSnapshotEpoch();
+
+            void EnterSnapshotScope();
+            void LeaveSnapshotScope();
+
+            // Starts a fresh snapshot epoch for one event and drops it again when the event is done.
+            struct SnapshotScope {
+                SnapshotScope() { EnterSnapshotScope(); }
+                ~SnapshotScope() { LeaveSnapshotScope(); }
+                SnapshotScope(const SnapshotScope&) = delete;
+                SnapshotScope& operator=(const SnapshotScope&) = delete;
+            };
+
+            using EntryIndex = std::unordered_map<FormID, RE::InventoryEntryData*>;
+
+            // Entry list of a_owner keyed by base FormID. Inside a SnapshotScope it is built at most once per snapshot
+            // epoch and owner; outside one, on every call. Favoriting does not move entries, so the index stays usable
+            // across a batch of SetFavorite calls, but anything else that may free an entry must end the epoch.
+            const EntryIndex& GetEntryIndex(RE::TESObjectREFR* inventory_owner);
+
+            // Drops the indexes before the epoch ends, for changes seen by events (container changes, load, new game).
+            // Safe to call from any thread.
+            void InvalidateEntryIndex();
+
+            RE::InventoryEntryData* FindEntry(const FormID formid, RE::TESObjectREFR* inventory_owner);
+
+            // Identity of an extra list among stacks of the same base object, from its enchantment, temper level and
+            // unique ID. Lists without any of these are interchangeable and all get 0. Collisions, by design:
+            //  - poison, enchantment charge and custom names are left out, since using or renaming the item would
+            //    change them; stacks that differ only in those share a fingerprint and FindInstance returns the first
+            //  - the temper level is exact, so two stacks tempered to the same level share one too
+            //  - unrelated fields colliding in the 32-bit hash are possible but not handled
+            // A favorite whose instance matches no stack goes on the first stack of the item; FavoriteItems logs it.
+            [[nodiscard]] std::uint32_t GetInstanceFingerprint(const RE::ExtraDataList* xList);
+
+            // The extra list of a_entry that carries the favorite, nullptr if there is none.
+            [[nodiscard]] RE::ExtraDataList* GetFavoritedList(const RE::InventoryEntryData* a_entry);
+
+            // Extra list of the instance formid/fingerprint, from an index built together with the entry index. Hits are
+            // checked against the entry, since its extra lists split and merge without an entry being added or removed.
+            RE::ExtraDataList* FindInstance(const FormID formid, const std::uint32_t fingerprint,
+                                            RE::TESObjectREFR* inventory_owner);
+
+            using Instance = ::Instance;
+
             const bool HasItemEntry(RE::TESBoundObject* item, RE::TESObjectREFR* inventory_owner,
                                     bool nonzero_entry_check = false);
 
@@ -74,6 +139,10 @@ namespace Utils {
 
             void FavoriteItem(const FormID formid, const FormID refid);
 
+            // Favorites the listed instances with one index lookup each, falling back to the first extra list of an
+            // item whose instance is gone. Returns the number favorited.
+            std::size_t FavoriteItems(std::span<const Instance> instances, RE::TESObjectREFR* inventory_owner);
+
             [[nodiscard]] const bool HasItemPlusCleanUp(RE::TESBoundObject* item, RE::TESObjectREFR* item_owner,
                                                         RE::ExtraDataList* xList = nullptr);
 
@@ -86,8 +155,68 @@ namespace Utils {
     
     };
     
-    bool read_string(SKSE::SerializationInterface* a_intfc, std::string& a_str);
+    // Builds a record in memory so it can be handed to the serialization interface with a single write.
+    class RecordWriter {
+    public:
+        inline void Reserve(const std::size_t n_bytes) { buffer.reserve(n_bytes); };
+
+        // keeps the capacity, so one writer can be reused for every chunk
+        inline void Clear() { buffer.clear(); };
+
+        template <class T>
+        void Write(const T& a_value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            WriteBytes(&a_value, sizeof(T));
+        };
+
+        void WriteBytes(const void* a_data, const std::size_t a_size);
+
+        // LEB128
+        void WriteVarint(std::uint64_t a_value);
+
+        // length-prefixed raw bytes
+        void WriteString(const std::string_view a_str);
+
+        [[nodiscard]] inline std::size_t Size() const { return buffer.size(); };
+
+        [[nodiscard]] bool Flush(SKSE::SerializationInterface* a_intfc) const;
+
+    private:
+        std::vector<std::uint8_t> buffer;
+    };
+
+    // Copies a whole record out of the serialization interface with one read and decodes it from memory.
+    class RecordReader {
+    public:
+        RecordReader(SKSE::SerializationInterface* a_intfc, const std::uint32_t a_length);
+
+        // decodes bytes already copied out of the interface
+        explicit RecordReader(std::vector<std::uint8_t> a_buffer) : buffer(std::move(a_buffer)) {};
 
-    bool write_string(SKSE::SerializationInterface* a_intfc, const std::string& a_str);
+        [[nodiscard]] inline explicit operator bool() const { return ok; };
+
+        [[nodiscard]] inline std::size_t Remaining() const { return buffer.size() - pos; };
+
+        template <class T>
+        [[nodiscard]] bool Read(T& a_value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return ReadBytes(&a_value, sizeof(T));
+        };
+
+        [[nodiscard]] bool ReadBytes(void* a_data, const std::size_t a_size);
+
+        [[nodiscard]] bool ReadVarint(std::uint64_t& a_value);
+
+        [[nodiscard]] bool ReadString(std::string& a_str);
+
+        // Editor IDs as written by plugin versions 0.1 and 0.2: a size_t count of std::pair<int, bool> per char.
+        [[nodiscard]] bool ReadLegacyString(std::string& a_str);
+
+    private:
+        std::vector<std::uint8_t> buffer;
+        std::size_t pos = 0;
+        bool ok = true;
+        std::vector<std::pair<int, bool>> legacy_scratch;
+    };
 
 };
\ No newline at end of file
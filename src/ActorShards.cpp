@@ -0,0 +1,252 @@
+#include "ActorShards.h"
+
+void ActorShards::Track(const RefID refid) {
+    if (!refid || refid == player_refid) return;
+    if (!GetReference(refid)) {
+        logger::warn("Track: Reference not found. RefID: {:x}", refid);
+        return;
+    }
+    if (shards.try_emplace(refid).second) {
+        layout_revision++;
+        Locker locker(queue_lock);
+        tracked.insert(refid);
+        logger::info("Tracking favorites of {:x}.", refid);
+    }
+    Record(refid);
+}
+
+void ActorShards::Untrack(const RefID refid) {
+    if (!shards.erase(refid)) return;
+    layout_revision++;
+    Locker locker(queue_lock);
+    tracked.erase(refid);
+    logger::info("Stopped tracking favorites of {:x}.", refid);
+}
+
+bool ActorShards::QueueItem(const RefID refid, const FormID formid) {
+    Locker locker(queue_lock);
+    if (!tracked.contains(refid)) return false;
+    // the record is decoded when the drain needs it, not in the event
+    queued_items.emplace_back(refid, formid);
+    return true;
+}
+
+void ActorShards::Record(const RefID refid) {
+    const auto shard = Get(refid);
+    const auto owner = GetReference(refid);
+    if (!shard || !owner) return;
+    ReferenceBackend backend(owner);
+    // references other than the player have no hotkeys, so the slots the reconciler fills are dropped
+    HotkeySlots slots;
+    Reconciler<ReferenceBackend>(backend, shard->data, slots).RecordItems(true);
+    LOG_TRACE("Recorded {} favorites of {:x}.", shard->data.Size(), refid);
+}
+
+void ActorShards::Restore(const RefID refid) {
+    const auto shard = Get(refid);
+    const auto owner = GetReference(refid);
+    if (!shard || !owner) return;
+    ReferenceBackend backend(owner);
+    HotkeySlots slots;
+    const auto restored = Reconciler<ReferenceBackend>(backend, shard->data, slots).RestoreItems();
+    LOG_TRACE("Restored {} favorites of {:x}.", restored.size(), refid);
+}
+
+std::size_t ActorShards::Drain() {
+    {
+        Locker locker(queue_lock);
+        drained_items.swap(queued_items);
+    }
+    for (const auto& [refid, formid] : drained_items) {
+        const auto it = shards.find(refid);
+        if (it == shards.end()) continue;
+        if (it->second.pending.empty()) dirty.push_back(refid);
+        it->second.pending.push_back(formid);
+    }
+    drained_items.clear();
+
+    std::size_t n_restored = 0;
+    for (const auto refid : std::exchange(dirty, {})) {
+        const auto shard = Get(refid);
+        if (!shard) continue;
+        auto& pending = shard->pending;
+        const auto owner = GetReference(refid);
+        std::ranges::sort(pending);
+        const auto [first, last] = std::ranges::unique(pending);
+        pending.erase(first, last);
+
+        std::pmr::vector<Utils::FunctionsSkyrim::Inventory::Instance> to_restore(EventArena::Get());
+        for (const auto formid : pending) {
+            if (owner && shard->data.Contains(formid)) to_restore.push_back({formid, shard->data.GetInstance(formid)});
+        }
+        [[maybe_unused]] const auto n_pending = pending.size();
+        // cleared rather than swapped out, so the queue keeps its capacity
+        pending.clear();
+        if (to_restore.empty()) continue;
+        n_restored += Utils::FunctionsSkyrim::Inventory::FavoriteItems(to_restore, owner);
+        LOG_TRACE("Drain: Restored {} of {} items of {:x}.", to_restore.size(), n_pending, refid);
+    }
+    return n_restored;
+}
+
+bool ActorShards::QueueRecord(SKSE::SerializationInterface* serializationInterface, unsigned int plugin_version,
+                              std::uint32_t length) {
+    assert(serializationInterface);
+    std::vector<std::uint8_t> bytes(length);
+    if (length && serializationInterface->ReadRecordData(bytes.data(), length) != length) {
+        logger::error("Failed to read reference record of {} bytes", length);
+        return false;
+    }
+    RefID refid;
+    if (bytes.size() < sizeof(refid)) {
+        logger::error("Reference record too short: {} bytes", length);
+        return false;
+    }
+    std::memcpy(&refid, bytes.data(), sizeof(refid));
+    if (!serializationInterface->ResolveFormID(refid, refid)) {
+        logger::warn("Failed to resolve reference, 0x{:X}. Its favorites are dropped.", refid);
+        return true;
+    }
+    bytes.erase(bytes.begin(), bytes.begin() + sizeof(refid));
+    auto& shard = shards[refid];
+    {
+        Locker locker(queue_lock);
+        tracked.insert(refid);
+    }
+    shard.raw = std::make_shared<const std::vector<std::uint8_t>>(std::move(bytes));
+    shard.plugin_version = plugin_version;
+    layout_revision++;
+    return true;
+}
+
+void ActorShards::FinishLoad(SKSE::SerializationInterface* serializationInterface) {
+    if (shards.empty()) return;
+    auto captured = std::make_shared<FormIDRemap>();
+    captured->Capture(serializationInterface);
+    remap = std::move(captured);
+    layout_revision++;
+    logger::info("Loaded {} tracked references.", shards.size());
+}
+
+void ActorShards::Publish() {
+    std::uint64_t revisions = 0;
+    for (const auto& [refid, shard] : shards) revisions += shard.data.Revision();
+    if (layout_revision == published_layout && revisions == published_revisions) return;
+    published_layout = layout_revision;
+    published_revisions = revisions;
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->shards.reserve(shards.size());
+    for (const auto& [refid, shard] : shards) {
+        snapshot->shards.push_back({refid, shard.data, shard.raw, shard.plugin_version});
+    }
+    snapshot->remap = remap;
+    published.store(std::move(snapshot), std::memory_order_release);
+}
+
+std::size_t ActorShards::Prune() {
+    std::size_t n_pruned = 0;
+    for (auto it = shards.begin(); it != shards.end();) {
+        const auto reference = GetReference(it->first);
+        if (reference && !reference->IsDeleted()) {
+            ++it;
+            continue;
+        }
+        {
+            Locker locker(queue_lock);
+            tracked.erase(it->first);
+        }
+        it = shards.erase(it);
+        n_pruned++;
+    }
+    if (n_pruned) {
+        layout_revision++;
+        logger::info("Stopped tracking {} references that no longer exist.", n_pruned);
+    }
+    return n_pruned;
+}
+
+bool ActorShards::Save(SKSE::SerializationInterface* serializationInterface, std::uint32_t type,
+                       std::uint32_t version) const {
+    assert(serializationInterface);
+    const auto snapshot = published.load(std::memory_order_acquire);
+    // records of the current format whose FormIDs all still mean the same forms can skip the decode
+    const auto format = Settings::version_map.at(version);
+    const bool same_load_order = snapshot->remap && snapshot->remap->IsIdentity();
+    Utils::RecordWriter writer;
+    FavoritesTable decoded;
+    for (const auto& [refid, data, raw, plugin_version] : snapshot->shards) {
+        if (!serializationInterface->OpenRecord(type, version)) {
+            logger::error("Failed to open record for reference {:x}!", refid);
+            return false;
+        }
+        writer.Clear();
+        if (raw && same_load_order && plugin_version == format) {
+            writer.Reserve(raw->size() + sizeof(refid));
+            writer.Write(refid);
+            writer.WriteBytes(raw->data(), raw->size());
+            if (!writer.Flush(serializationInterface)) {
+                logger::error("Failed to save the record of {:x}", refid);
+                return false;
+            }
+            LOG_TRACE("Saved the record of {:x} as loaded, {} bytes", refid, writer.Size());
+            continue;
+        }
+        // other untouched shards are decoded into a scratch table, so they are written in the current load order
+        if (raw) {
+            decoded.Clear();
+            Decode(refid, *raw, plugin_version, snapshot->remap.get(), decoded);
+        }
+        const auto& shard_data = raw ? decoded : data;
+        const auto rows = SaveLoadData::SaveableRows(shard_data);
+        writer.Reserve(rows.size() * 28 + 16);
+        writer.Write(refid);
+        // one chunk, so the record decodes like any chunk of the player's table
+        writer.WriteVarint(0);
+        writer.WriteVarint(1);
+        SaveLoadData::WriteRows(writer, shard_data, rows, 0, rows.size());
+        if (!writer.Flush(serializationInterface)) {
+            logger::error("Failed to save {} favorites of {:x}", rows.size(), refid);
+            return false;
+        }
+        LOG_TRACE("Saved {} favorites of {:x} in {} bytes", rows.size(), refid, writer.Size());
+    }
+    return true;
+}
+
+void ActorShards::Clear() {
+    shards.clear();
+    dirty.clear();
+    layout_revision++;
+    {
+        Locker locker(queue_lock);
+        tracked.clear();
+        queued_items.clear();
+    }
+    remap.reset();
+}
+
+ActorShards::Shard* ActorShards::Get(const RefID refid) {
+    const auto it = shards.find(refid);
+    if (it == shards.end()) return nullptr;
+    auto& shard = it->second;
+    if (!shard.raw) return &shard;
+    Decode(refid, *std::exchange(shard.raw, {}), shard.plugin_version, remap.get(), shard.data);
+    layout_revision++;
+    return &shard;
+}
+
+void ActorShards::Decode(const RefID refid, const std::vector<std::uint8_t>& bytes, const unsigned int plugin_version,
+                         const FormIDRemap* remap, FavoritesTable& data) {
+    Utils::RecordReader reader(bytes);
+    std::vector<SaveLoadData::SavedRow> rows;
+    const SaveLoadData::Resolver resolve = [remap](FormID& formid) { return remap && remap->Resolve(formid, formid); };
+    if (!SaveLoadData::Decode(reader, plugin_version, resolve, rows)) {
+        logger::critical("Failed to decode the favorites of {:x}", refid);
+    }
+    SaveLoadData::InsertRows(data, rows);
+    LOG_TRACE("Decoded {} favorites of {:x}.", rows.size(), refid);
+}
+
+RE::TESObjectREFR* ActorShards::GetReference(const RefID refid) {
+    return RE::TESForm::LookupByID<RE::TESObjectREFR>(refid);
+}
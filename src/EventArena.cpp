@@ -0,0 +1,89 @@
+#include "EventArena.h"
+
+namespace EventArena {
+
+    namespace {
+        // Passes allocations on to upstream, counting what they took.
+        class CountingResource : public std::pmr::memory_resource {
+        public:
+            explicit CountingResource(std::pmr::memory_resource* a_upstream) : upstream(a_upstream) {}
+
+            std::size_t bytes = 0;
+
+        private:
+            std::pmr::memory_resource* upstream;
+
+            void* do_allocate(const std::size_t a_bytes, const std::size_t a_alignment) override {
+                bytes += a_bytes;
+                return upstream->allocate(a_bytes, a_alignment);
+            }
+
+            void do_deallocate(void* a_ptr, const std::size_t a_bytes, const std::size_t a_alignment) override {
+                upstream->deallocate(a_ptr, a_bytes, a_alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& a_other) const noexcept override {
+                return this == &a_other;
+            }
+        };
+
+        struct Arena {
+            std::vector<std::byte> buffer = std::vector<std::byte>(initial_capacity);
+            // heap fallback for events that outgrow the buffer
+            CountingResource overflow{std::pmr::new_delete_resource()};
+            std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size(), &overflow};
+            // what the handlers allocate from, so the arena knows how much the last event used
+            CountingResource front{&resource};
+            unsigned int quiet = 0;
+
+            void Release() {
+                const auto used = std::exchange(front.bytes, 0);
+                resource.release();
+                if (overflow.bytes) {
+                    quiet = 0;
+                    // regrow to what the last event needed, so events of its size stop spilling to the heap
+                    const auto needed = std::min(std::bit_ceil(buffer.size() + overflow.bytes), max_capacity);
+                    overflow.bytes = 0;
+                    if (needed > buffer.size()) Resize(needed);
+                    return;
+                }
+                if (buffer.size() == initial_capacity) return;
+                if (used > initial_capacity) {
+                    quiet = 0;
+                    return;
+                }
+                // one large event should not pin a large buffer for the rest of the session
+                if (++quiet < quiet_releases) return;
+                quiet = 0;
+                Resize(initial_capacity);
+            }
+
+            void Resize(const std::size_t a_size) {
+                LOG_TRACE("EventArena: Resizing from {} to {} bytes.", buffer.size(), a_size);
+                buffer = std::vector<std::byte>(a_size);
+                std::destroy_at(&resource);
+                std::construct_at(&resource, buffer.data(), buffer.size(), &overflow);
+            }
+        };
+
+        Arena& GetArena() {
+            thread_local Arena arena;
+            return arena;
+        }
+
+        thread_local unsigned int depth = 0;
+    };
+
+    std::pmr::memory_resource* Get() {
+        return depth ? &GetArena().front : std::pmr::get_default_resource();
+    }
+
+    Scope::Scope() { depth++; }
+
+    Scope::~Scope() {
+        if (--depth) return;
+        GetArena().Release();
+    }
+
+    std::size_t Capacity() { return GetArena().buffer.size(); }
+};
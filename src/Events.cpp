@@ -3,6 +3,7 @@
 
 RE::BSEventNotifyControl myEventSink::ProcessEvent(RE::InputEvent* const* evns, RE::BSTEventSource<RE::InputEvent*>*) {
     if (!*evns) return RE::BSEventNotifyControl::kContinue;
+    const Stats::ScopedTimer timer(Stats::Probe::kInput);
     for (RE::InputEvent* e = *evns; e; e = e->next) {
         if (e->eventType.get() != RE::INPUT_EVENT_TYPE::kButton) continue;
         const RE::ButtonEvent* a_event = e->AsButtonEvent();
@@ -11,11 +12,11 @@ RE::BSEventNotifyControl myEventSink::ProcessEvent(RE::InputEvent* const* evns,
         const auto& userEvent = id_event->userEvent;
         const auto userevents = RE::UserEvents::GetSingleton();
         if (IsHotkeyEvent(userEvent) && Utils::FunctionsSkyrim::Menu::IsOpen(RE::FavoritesMenu::MENU_NAME)) {
-            logger::trace("User event: {}", userEvent.c_str());
-            M->SyncFavorites();
+            LOG_TRACE("User event: {}", userEvent.c_str());
+            RequestSync();
         }
         else if (userEvent == userevents->toggleFavorite || userEvent == userevents->yButton){
-            M->SyncFavorites();
+            RequestSync();
         }
         return RE::BSEventNotifyControl::kContinue;
     }
@@ -25,8 +26,24 @@ RE::BSEventNotifyControl myEventSink::ProcessEvent(RE::InputEvent* const* evns,
 RE::BSEventNotifyControl myEventSink::ProcessEvent(const RE::TESContainerChangedEvent* event,
                                                    RE::BSTEventSource<RE::TESContainerChangedEvent>*) {
     if (!event) return RE::BSEventNotifyControl::kContinue;
-    if (event->newContainer!=player_refid) return RE::BSEventNotifyControl::kContinue;
-    M->FavoriteCheck_Item(event->baseObj);
+    // an event may fire in the middle of a scope, after the change already dropped entries the index points at
+    if (event->oldContainer == player_refid || event->newContainer == player_refid) {
+        Utils::FunctionsSkyrim::Inventory::InvalidateEntryIndex();
+        M->NoteInventoryChange();
+    }
+    if (event->newContainer != player_refid) {
+        // one lookup, and only for the references that are not the player
+        if (M->QueueReferenceItem(event->newContainer, event->baseObj)) {
+            Locker locker(event_lock);
+            ScheduleDrain();
+        }
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    const Stats::ScopedTimer timer(Stats::Probe::kContainer, 1);
+    // take all and bulk transfers fire one event per stack
+    Locker locker(event_lock);
+    pending_items.push_back(event->baseObj);
+    ScheduleDrain();
     return RE::BSEventNotifyControl::kContinue;
 }
 
@@ -37,37 +54,131 @@ RE::BSEventNotifyControl myEventSink::ProcessEvent(const RE::MenuOpenCloseEvent*
         event->menuName != RE::InventoryMenu::MENU_NAME &&
         event->menuName != RE::ContainerMenu::MENU_NAME &&
         event->menuName != RE::MagicMenu::MENU_NAME) return RE::BSEventNotifyControl::kContinue;
-    logger::trace("Menu event: {}", event->menuName.c_str());
-    M->AddFavorites();
-    if (event->opening) {
-        auto player_ref = RE::PlayerCharacter::GetSingleton()->AsReference();
-        SKSE::GetTaskInterface()->AddTask([player_ref]() { RE::SendUIMessage::SendInventoryUpdateMessage(player_ref, nullptr);
-		});
+    LOG_TRACE("Menu event: {}", event->menuName.c_str());
+    const Stats::ScopedTimer timer(Stats::Probe::kMenu);
+    if (event->menuName == RE::ContainerMenu::MENU_NAME) {
+        if (const auto target = Utils::FunctionsSkyrim::Menu::GetContainerMenuTarget()) {
+            Locker locker(event_lock);
+            (event->opening ? opened_reference : closed_reference) = target;
+        }
     }
+    // the hooks miss favorites changed through pointers or by other plugins, so a closing menu records them all
+    if (!event->opening && M->IsDeltaTracking()) RequestSync(true);
+    RequestRestore(event->opening);
     return RE::BSEventNotifyControl::kContinue;
 }
 
 RE::BSEventNotifyControl myEventSink::ProcessEvent(const RE::SpellsLearned::Event* a_event,
                                              RE::BSTEventSource<RE::SpellsLearned::Event>*) {
     if (!a_event) return RE::BSEventNotifyControl::kContinue;
-    M->FavoriteCheck_Spell();
+    const Stats::ScopedTimer timer(Stats::Probe::kSpellsLearned, 1);
+    M->InvalidatePlayerSpells();
+    // mods that grant spell packs fire one event per spell in the same frame
+    Locker locker(event_lock);
+    if (a_event->spell) pending_spells.push_back(a_event->spell->GetFormID());
+    else spell_check_requested = true;
+    ScheduleDrain();
     return RE::BSEventNotifyControl::kContinue;
 }
 
-bool myEventSink::IsHotkeyEvent(const RE::BSFixedString& event_name) const {
-    return Utils::Functions::String::includesString(std::string(event_name.c_str()), {"Hotkey"});
+bool myEventSink::IsHotkeyEvent(const RE::BSFixedString& event_name) {
+    if (!hotkey_events_ready) {
+        const auto userevents = RE::UserEvents::GetSingleton();
+        hotkey_events = {userevents->hotkey1, userevents->hotkey2, userevents->hotkey3, userevents->hotkey4,
+                         userevents->hotkey5, userevents->hotkey6, userevents->hotkey7, userevents->hotkey8};
+        hotkey_events_ready = true;
+    }
+    return std::ranges::find(hotkey_events, event_name) != hotkey_events.end();
 };
 
+void myEventSink::RequestSync(const bool a_full) {
+    Locker locker(event_lock);
+    sync_requested = true;
+    full_sync_requested |= a_full;
+    ScheduleDrain();
+}
+
+void myEventSink::RequestRestore(const bool update_ui) {
+    Locker locker(event_lock);
+    restore_requested = true;
+    ui_update_requested |= update_ui;
+    ScheduleDrain();
+}
+
+void myEventSink::ScheduleDrain() {
+    if (drain_scheduled) return;
+    drain_scheduled = true;
+    SKSE::GetTaskInterface()->AddTask([this]() { Drain(); });
+}
+
+void myEventSink::Drain() {
+    bool sync, full_sync, restore, update_ui, spell_check;
+    RefID opened, closed;
+    {
+        // events raised from here on schedule the next drain
+        Locker locker(event_lock);
+        sync = std::exchange(sync_requested, false);
+        full_sync = std::exchange(full_sync_requested, false);
+        restore = std::exchange(restore_requested, false);
+        update_ui = std::exchange(ui_update_requested, false);
+        drained_items.swap(pending_items);
+        drained_spells.swap(pending_spells);
+        spell_check = std::exchange(spell_check_requested, false);
+        opened = std::exchange(opened_reference, 0);
+        closed = std::exchange(closed_reference, 0);
+        drain_scheduled = false;
+    }
+    auto& items = drained_items;
+    auto& spells = drained_spells;
+    // items: the passes that ran plus the container changes and learned spells batched into this frame
+    const Stats::ScopedTimer timer(Stats::Probe::kDrain, sync + restore + spell_check + items.size() + spells.size());
+
+    {
+        // the passes' temporaries live in the arena until the frame's work is done
+        const EventArena::Scope arena_scope;
+        const Utils::FunctionsSkyrim::Inventory::SnapshotScope snapshot_scope;
+        // record what the player changed before restoring over it
+        if (sync) M->SyncFavorites(full_sync);
+        // a full restore covers the items and spells that came in this frame; the menus only need refreshing if it
+        // actually ran
+        if (restore) update_ui &= M->AddFavorites();
+        else {
+            if (!items.empty()) M->FavoriteCheck_Items(items);
+            if (spell_check) M->FavoriteCheck_Spell();
+            else if (!spells.empty()) M->FavoriteCheck_Spells(spells);
+        }
+        // after the player, so the player's inventory index is built once per frame
+        if (closed) M->SyncFavorites_Reference(closed);
+        if (opened) M->AddFavorites_Reference(opened);
+        M->FavoriteCheck_References();
+    }
+    items.clear();
+    spells.clear();
+    M->Publish();
+    if (update_ui) {
+        RE::SendUIMessage::SendInventoryUpdateMessage(RE::PlayerCharacter::GetSingleton()->AsReference(), nullptr);
+    }
+}
+
 void myEventSink::SaveCallback(SKSE::SerializationInterface* serializationInterface) {
+    // a save right after a load would otherwise write the table before the deferred restore filled it
+    M->CompleteRestore();
+    const Stats::ScopedTimer timer(Stats::Probe::kSave, M->GetSnapshot()->Size());
     M->SendData();
+    M->PruneReferences();
     if (!M->Save(serializationInterface, Settings::kDataKey, Settings::kSerializationVersion)) {
         logger::critical("Failed to save Data");
     }
+    if (!M->SaveReferences(serializationInterface)) {
+        logger::critical("Failed to save the favorites of tracked references");
+    }
+    if (!M->SaveProfileID(serializationInterface)) logger::critical("Failed to save the profile id");
 }
 
 void myEventSink::LoadCallback(SKSE::SerializationInterface* serializationInterface){
 
     logger::info("Loading Data from skse co-save.");
+    Stats::ScopedTimer timer(Stats::Probe::kLoad);
 
     M->Reset();
 
@@ -77,6 +188,8 @@ void myEventSink::LoadCallback(SKSE::SerializationInterface* serializationInterf
 
     bool cosave_found = false;
     unsigned int received_version = 0;
+    // large tables come in several records of the same type, each loaded as it is read
+    unsigned int n_records = 0;
     while (serializationInterface->GetNextRecordInfo(type, version, length)) {
         
         auto temp = Utils::DecodeTypeCode(type);
@@ -90,9 +203,24 @@ void myEventSink::LoadCallback(SKSE::SerializationInterface* serializationInterf
         switch (type) {
             case Settings::kDataKey: {
                 received_version = Settings::version_map.at(version);
-                logger::trace("Loading Record: {} - Version: {} - Length: {}", temp, version, length);
-                if (!M->Load(serializationInterface, received_version)) logger::critical("Failed to Load Data for Manager");
-                else cosave_found = true;
+                LOG_TRACE("Loading Record: {} - Version: {} - Length: {}", temp, version, length);
+                // only copied here; decoding runs on a worker once every record is in
+                if (!M->QueueRecord(serializationInterface, received_version, length)) logger::critical("Failed to Load Data for Manager");
+                else {
+                    cosave_found = true;
+                    n_records++;
+                }
+            } break;
+            case Settings::kActorKey: {
+                LOG_TRACE("Loading Record: {} - Version: {} - Length: {}", temp, version, length);
+                // kept undecoded until the reference is needed
+                if (!M->QueueReferenceRecord(serializationInterface, Settings::version_map.at(version), length)) {
+                    logger::critical("Failed to Load Data for a tracked reference");
+                }
+            } break;
+            case Settings::kProfileKey: {
+                LOG_TRACE("Loading Record: {} - Version: {} - Length: {}", temp, version, length);
+                if (!M->LoadProfileID(serializationInterface, length)) logger::critical("Failed to load the profile id");
             } break;
             default:
                 logger::critical("Unrecognized Record Type: {}", temp);
@@ -103,9 +231,15 @@ void myEventSink::LoadCallback(SKSE::SerializationInterface* serializationInterf
     if (cosave_found) {
         std::ostringstream oss;
         oss << std::fixed << std::setprecision(1) << received_version / 10.f;
-        logger::info("Receiving Data from cosave with plugin version: {}.", oss.str());
-        M->ReceiveData();
+        logger::info("Receiving Data from cosave with plugin version: {}. Records: {}", oss.str(), n_records);
         logger::info("Data loaded from skse co-save.");
     } else logger::info("No cosave data found.");
 
+    M->StartDecode(serializationInterface);
+    M->FinishReferenceLoad(serializationInterface);
+    // also runs without a cosave, so a save whose favorites record is missing picks up the character's profile
+    M->ReceiveData(cosave_found);
+    M->Publish();
+    timer.SetItems(n_records);
+
 };
@@ -0,0 +1,337 @@
+#include "FavoritesTable.h"
+
+namespace {
+    // Whether a holder other than this one still shares p. A count of one also means every other holder is done
+    // with it, so the acquire fence makes their reads happen before the write that follows.
+    template <class T>
+    bool IsShared(const std::shared_ptr<T>& p) {
+        if (p.use_count() > 1) return true;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return false;
+    }
+
+    std::uint8_t ToNibble(const int hotkey) {
+        return hotkey >= 0 && hotkey < FavoritesTable::no_hotkey ? static_cast<std::uint8_t>(hotkey)
+                                                                 : FavoritesTable::no_hotkey;
+    }
+};
+
+std::uint8_t FavoritesTable::Block::GetNibble(const std::size_t row) const {
+    const auto byte = hotkeys[row / 2];
+    return row % 2 ? byte >> 4 : byte & 0xF;
+}
+
+void FavoritesTable::Block::SetNibble(const std::size_t row, const std::uint8_t value) {
+    auto& byte = hotkeys[row / 2];
+    byte = row % 2 ? static_cast<std::uint8_t>((byte & 0x0F) | (value << 4))
+                   : static_cast<std::uint8_t>((byte & 0xF0) | (value & 0xF));
+}
+
+void FavoritesTable::Block::Insert(const std::size_t row, const FormID formid, const std::uint8_t hotkey,
+                                   const std::uint32_t editorid, const std::uint32_t instance) {
+    formids.insert(formids.begin() + row, formid);
+    editorids.insert(editorids.begin() + row, editorid);
+    instances.insert(instances.begin() + row, instance);
+    if (hotkeys.size() * 2 < formids.size()) hotkeys.push_back(0xFF);
+    // shift the nibbles after row up by one
+    for (auto i = formids.size() - 1; i > row; i--) SetNibble(i, GetNibble(i - 1));
+    SetNibble(row, hotkey);
+}
+
+void FavoritesTable::Block::Erase(const std::size_t row) {
+    for (auto i = row; i + 1 < formids.size(); i++) SetNibble(i, GetNibble(i + 1));
+    formids.erase(formids.begin() + row);
+    editorids.erase(editorids.begin() + row);
+    instances.erase(instances.begin() + row);
+    hotkeys.resize((formids.size() + 1) / 2);
+}
+
+void FavoritesTable::Block::Append(const Block& other, const std::size_t first, const std::size_t last) {
+    auto row = formids.size();
+    formids.insert(formids.end(), other.formids.begin() + first, other.formids.begin() + last);
+    editorids.insert(editorids.end(), other.editorids.begin() + first, other.editorids.begin() + last);
+    instances.insert(instances.end(), other.instances.begin() + first, other.instances.begin() + last);
+    hotkeys.resize((formids.size() + 1) / 2, 0xFF);
+    for (auto i = first; i < last; i++) SetNibble(row++, other.GetNibble(i));
+}
+
+FavoritesTable::FavoritesTable() : pages{std::make_shared<Page>()} {}
+
+FavoritesTable::FavoritesTable(const FavoritesTable& other)
+    : blocks(other.blocks),
+      block_ends(other.block_ends),
+      pages(other.pages),
+      n_strings(other.n_strings),
+      strings_indexed(false),
+      revision(other.revision) {}
+
+FavoritesTable& FavoritesTable::operator=(const FavoritesTable& other) {
+    if (this == &other) return *this;
+    blocks = other.blocks;
+    block_ends = other.block_ends;
+    pages = other.pages;
+    n_strings = other.n_strings;
+    strings_indexed = false;
+    string_index.clear();
+    string_refs.clear();
+    free_strings.clear();
+    revision = other.revision;
+    return *this;
+}
+
+void FavoritesTable::IndexStrings() {
+    if (strings_indexed) return;
+    strings_indexed = true;
+    string_refs.assign(n_strings, 0);
+    for (const auto& block : blocks) {
+        for (const auto index : block->editorids) string_refs[index]++;
+    }
+    string_index.clear();
+    free_strings.clear();
+    for (std::uint32_t i = 1; i < n_strings; i++) {
+        if (string_refs[i]) string_index.emplace(StringAt(i), i);
+        else free_strings.push_back(i);
+    }
+}
+
+FavoritesTable::Position FavoritesTable::Find(const FormID formid) const {
+    if (blocks.empty()) return {};
+    // the first block that ends at or past formid, else the last one, which an insert appends to
+    const auto it = std::ranges::lower_bound(blocks, formid, {}, [](const auto& block) { return block->formids.back(); });
+    const auto block = it == blocks.end() ? blocks.size() - 1 : static_cast<std::size_t>(it - blocks.begin());
+    const auto& formids = blocks[block]->formids;
+    const auto row = std::ranges::lower_bound(formids, formid);
+    return {block, static_cast<std::size_t>(row - formids.begin()), row != formids.end() && *row == formid};
+}
+
+FavoritesTable::Position FavoritesTable::Locate(const std::size_t row) const {
+    const auto block = static_cast<std::size_t>(std::ranges::upper_bound(block_ends, row) - block_ends.begin());
+    return {block, block ? row - block_ends[block - 1] : row, true};
+}
+
+FavoritesTable::Block& FavoritesTable::MutableBlock(const std::size_t block) {
+    auto& shared = blocks[block];
+    if (IsShared(shared)) shared = std::make_shared<Block>(*shared);
+    return *shared;
+}
+
+FavoritesTable::Page& FavoritesTable::MutablePage(const std::size_t page) {
+    auto& shared = pages[page];
+    if (!IsShared(shared)) return *shared;
+    // the old page stays alive until its index entries point at the clone
+    const auto old_page = std::exchange(shared, std::make_shared<Page>(*shared));
+    const auto first = static_cast<std::uint32_t>(page * page_strings);
+    const auto last = std::min<std::uint32_t>(n_strings, first + page_strings);
+    for (auto i = std::max<std::uint32_t>(first, 1); i < last; i++) {
+        if (!string_refs[i]) continue;
+        auto node = string_index.extract((*old_page)[i - first]);
+        node.key() = (*shared)[i - first];
+        string_index.insert(std::move(node));
+    }
+    return *shared;
+}
+
+void FavoritesTable::UpdateBlockEnds(const std::size_t block) {
+    block_ends.resize(blocks.size());
+    for (auto i = block; i < blocks.size(); i++) block_ends[i] = (i ? block_ends[i - 1] : 0) + blocks[i]->Size();
+}
+
+std::uint32_t FavoritesTable::Intern(const std::string_view str) {
+    if (str.empty()) return 0;
+    IndexStrings();
+    if (const auto it = string_index.find(str); it != string_index.end()) {
+        string_refs[it->second]++;
+        return it->second;
+    }
+    std::uint32_t index;
+    if (!free_strings.empty()) {
+        index = free_strings.back();
+        free_strings.pop_back();
+    } else {
+        index = n_strings++;
+        string_refs.push_back(0);
+        if (index / page_strings == pages.size()) pages.push_back(std::make_shared<Page>());
+    }
+    auto& stored = MutablePage(index / page_strings)[index % page_strings];
+    stored = str;
+    string_refs[index] = 1;
+    string_index.emplace(stored, index);
+    return index;
+}
+
+void FavoritesTable::ReleaseString(const std::uint32_t index) {
+    if (!index) return;
+    IndexStrings();
+    if (--string_refs[index]) return;
+    string_index.erase(StringAt(index));
+    // swapped out rather than cleared, so the slot gives its buffer back
+    std::string().swap(MutablePage(index / page_strings)[index % page_strings]);
+    free_strings.push_back(index);
+}
+
+bool FavoritesTable::Insert(const FormID formid, const int hotkey, const std::string_view editorid,
+                            const std::uint32_t instance) {
+    const auto position = Find(formid);
+    if (position.found) return false;
+    if (blocks.empty()) blocks.push_back(std::make_shared<Block>());
+    auto& block = MutableBlock(position.block);
+    block.Insert(position.row, formid, ToNibble(hotkey), Intern(editorid), instance);
+    if (block.Size() > 2 * block_rows) {
+        // split in half, so both halves have room to grow again
+        auto upper = std::make_shared<Block>();
+        upper->Append(block, block_rows, block.Size());
+        auto lower = std::make_shared<Block>();
+        lower->Append(block, 0, block_rows);
+        blocks[position.block] = std::move(lower);
+        blocks.insert(blocks.begin() + position.block + 1, std::move(upper));
+    }
+    UpdateBlockEnds(position.block);
+    revision++;
+    return true;
+}
+
+std::size_t FavoritesTable::InsertRows(const std::span<const Row> rows) {
+    if (rows.empty()) return 0;
+    // a few rows are cheaper to insert in place than to rebuild every block for
+    if (rows.size() <= blocks.size()) {
+        std::size_t n_inserted = 0;
+        for (const auto& [formid, hotkey, editorid, instance] : rows) {
+            n_inserted += Insert(formid, hotkey, editorid, instance);
+        }
+        return n_inserted;
+    }
+    // sort the batch once; stable, so unique keeps the first row of a repeated FormID
+    std::vector<const Row*> batch;
+    batch.reserve(rows.size());
+    for (const auto& row : rows) batch.push_back(&row);
+    const auto by_formid = [](const Row* row) { return row->formid; };
+    std::ranges::stable_sort(batch, {}, by_formid);
+    const auto [first, last] = std::ranges::unique(batch, {}, by_formid);
+    batch.erase(first, last);
+
+    // merge the old rows and the batch into fresh blocks of block_rows each
+    std::vector<std::shared_ptr<Block>> merged;
+    merged.reserve((Size() + batch.size()) / block_rows + 1);
+    const auto target = [&merged]() -> Block& {
+        if (merged.empty() || merged.back()->Size() >= block_rows) merged.push_back(std::make_shared<Block>());
+        return *merged.back();
+    };
+    std::size_t n_inserted = 0;
+    auto next = batch.begin();
+    const auto insert_next = [&]() {
+        const auto& [formid, hotkey, editorid, instance] = **next++;
+        auto& block = target();
+        block.Insert(block.Size(), formid, ToNibble(hotkey), Intern(editorid), instance);
+        n_inserted++;
+    };
+    for (const auto& block : blocks) {
+        for (std::size_t row = 0; row < block->Size(); row++) {
+            const auto formid = block->formids[row];
+            while (next != batch.end() && (*next)->formid < formid) insert_next();
+            // already in the table
+            if (next != batch.end() && (*next)->formid == formid) ++next;
+            target().Append(*block, row, row + 1);
+        }
+    }
+    while (next != batch.end()) insert_next();
+    if (!n_inserted) return 0;
+    blocks = std::move(merged);
+    UpdateBlockEnds(0);
+    revision++;
+    return n_inserted;
+}
+
+bool FavoritesTable::Erase(const FormID formid) {
+    const auto position = Find(formid);
+    if (!position.found) return false;
+    auto& block = MutableBlock(position.block);
+    ReleaseString(block.editorids[position.row]);
+    block.Erase(position.row);
+    if (!block.Size()) {
+        blocks.erase(blocks.begin() + position.block);
+    } else if (position.block + 1 < blocks.size() && block.Size() + blocks[position.block + 1]->Size() <= block_rows) {
+        // keep erases from leaving a trail of small blocks behind
+        block.Append(*blocks[position.block + 1], 0, blocks[position.block + 1]->Size());
+        blocks.erase(blocks.begin() + position.block + 1);
+    }
+    UpdateBlockEnds(position.block);
+    revision++;
+    return true;
+}
+
+void FavoritesTable::Clear() {
+    blocks.clear();
+    block_ends.clear();
+    pages.assign(1, std::make_shared<Page>());
+    n_strings = 1;
+    strings_indexed = true;
+    string_index.clear();
+    string_refs.assign(1, 0);
+    free_strings.clear();
+    revision++;
+}
+
+const int FavoritesTable::GetHotkey(const FormID formid) const {
+    const auto position = Find(formid);
+    if (!position.found) return -1;
+    const auto hotkey = blocks[position.block]->GetNibble(position.row);
+    return hotkey == no_hotkey ? -1 : hotkey;
+}
+
+void FavoritesTable::SetHotkey(const FormID formid, const int hotkey) {
+    const auto position = Find(formid);
+    if (!position.found) return;
+    const auto value = ToNibble(hotkey);
+    if (blocks[position.block]->GetNibble(position.row) == value) return;
+    MutableBlock(position.block).SetNibble(position.row, value);
+    revision++;
+}
+
+const std::string& FavoritesTable::GetEditorID(const FormID formid) const {
+    const auto position = Find(formid);
+    return StringAt(position.found ? blocks[position.block]->editorids[position.row] : 0);
+}
+
+void FavoritesTable::SetEditorID(const FormID formid, const std::string_view editorid) {
+    const auto position = Find(formid);
+    if (!position.found) return;
+    const auto old_index = blocks[position.block]->editorids[position.row];
+    if (StringAt(old_index) == editorid) return;
+    // released first, so the new editor ID can take over the slot the old one frees
+    ReleaseString(old_index);
+    MutableBlock(position.block).editorids[position.row] = Intern(editorid);
+    revision++;
+}
+
+const std::uint32_t FavoritesTable::GetInstance(const FormID formid) const {
+    const auto position = Find(formid);
+    return position.found ? blocks[position.block]->instances[position.row] : any_instance;
+}
+
+void FavoritesTable::SetInstance(const FormID formid, const std::uint32_t instance) {
+    const auto position = Find(formid);
+    if (!position.found || blocks[position.block]->instances[position.row] == instance) return;
+    MutableBlock(position.block).instances[position.row] = instance;
+    revision++;
+}
+
+FormID FavoritesTable::FormIDAt(const std::size_t row) const {
+    const auto position = Locate(row);
+    return blocks[position.block]->formids[position.row];
+}
+
+const int FavoritesTable::HotkeyAt(const std::size_t row) const {
+    const auto position = Locate(row);
+    const auto hotkey = blocks[position.block]->GetNibble(position.row);
+    return hotkey == no_hotkey ? -1 : hotkey;
+}
+
+const std::string& FavoritesTable::EditorIDAt(const std::size_t row) const {
+    const auto position = Locate(row);
+    return StringAt(blocks[position.block]->editorids[position.row]);
+}
+
+std::uint32_t FavoritesTable::InstanceAt(const std::size_t row) const {
+    const auto position = Locate(row);
+    return blocks[position.block]->instances[position.row];
+}
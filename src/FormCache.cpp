@@ -0,0 +1,49 @@
+#include "FormCache.h"
+
+FormCache::Entry FormCache::Get(const RE::TESForm* form) {
+    if (!form) return {};
+    const auto formid = form->GetFormID();
+    {
+        std::shared_lock read_lock(lock);
+        if (const auto it = entries.find(formid); it != entries.end()) return it->second;
+    }
+
+    const auto editorid = clib_util::editorID::get_editorID(form);
+    Entry entry{0, form->GetFormType(), std::strlen(form->GetName()) > 0};
+
+    std::unique_lock write_lock(lock);
+    if (!editorid.empty()) {
+        if (const auto it = string_index.find(editorid); it != string_index.end()) {
+            entry.editorid = it->second;
+        } else {
+            entry.editorid = static_cast<std::uint32_t>(strings.size());
+            string_index.emplace(strings.emplace_back(editorid), entry.editorid);
+        }
+    }
+    return entries.try_emplace(formid, entry).first->second;
+}
+
+FormCache::Entry FormCache::Get(const FormID formid) {
+    {
+        std::shared_lock read_lock(lock);
+        if (const auto it = entries.find(formid); it != entries.end()) return it->second;
+    }
+    return Get(RE::TESForm::LookupByID(formid));
+}
+
+const std::string& FormCache::GetEditorID(const Entry& entry) {
+    std::shared_lock read_lock(lock);
+    return strings[entry.editorid];
+}
+
+const std::string& FormCache::GetEditorID(const RE::TESForm* form) { return GetEditorID(Get(form)); }
+
+const std::string& FormCache::GetEditorID(const FormID formid) {
+    return GetEditorID(RE::TESForm::LookupByID(formid));
+}
+
+void FormCache::ClearDynamic() {
+    std::unique_lock write_lock(lock);
+    std::erase_if(entries, [](const auto& item) { return item.first >> 24 == 0xFF; });
+    LOG_TRACE("Form cache: {} entries, {} editor IDs.", entries.size(), strings.size() - 1);
+}
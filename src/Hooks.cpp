@@ -0,0 +1,117 @@
+#include "Hooks.h"
+
+namespace {
+
+    struct PendingHook {
+        const char* name;
+        std::uintptr_t target;
+        std::uintptr_t thunk;
+        void (*set_func)(std::uintptr_t);
+        std::vector<std::uintptr_t> call_sites;
+    };
+
+    template <class T>
+    PendingHook Prepare(const char* a_name) {
+        const REL::Relocation<std::uintptr_t> target{T::id};
+        PendingHook hook{a_name, target.address(), reinterpret_cast<std::uintptr_t>(&T::thunk),
+                         [](const std::uintptr_t a_func) { T::func = a_func; }};
+        for (const auto& [caller, offset] : T::call_sites) {
+            const REL::Relocation<std::uintptr_t> call_site{caller, offset};
+            hook.call_sites.push_back(call_site.address());
+        }
+        return hook;
+    }
+};
+
+namespace Hooks {
+
+    bool IsCallTo(const std::uintptr_t a_site, const std::uintptr_t a_target) {
+        const auto* code = reinterpret_cast<const std::uint8_t*>(a_site);
+        if (!code || code[0] != 0xE8) return false;
+        std::int32_t rel;
+        std::memcpy(&rel, code + 1, sizeof(rel));
+        return a_site + 5 + static_cast<std::intptr_t>(rel) == a_target;
+    }
+
+    void InventorySetFavorite::thunk(RE::InventoryChanges* a_this, RE::InventoryEntryData* a_entry,
+                                     RE::ExtraDataList* a_itemList) {
+        func(a_this, a_entry, a_itemList);
+        if (!a_this || a_this->owner != RE::PlayerCharacter::GetSingleton()) return;
+        Manager::GetSingleton()->QueueDelta(a_entry, a_itemList);
+    }
+
+    void InventoryRemoveFavorite::thunk(RE::InventoryChanges* a_this, RE::InventoryEntryData* a_entry,
+                                        RE::ExtraDataList* a_itemList) {
+        func(a_this, a_entry, a_itemList);
+        if (!a_this || a_this->owner != RE::PlayerCharacter::GetSingleton()) return;
+        Manager::GetSingleton()->QueueDelta(a_entry);
+    }
+
+    void MagicSetFavorite::thunk(RE::MagicFavorites* a_this, RE::TESForm* a_form) {
+        func(a_this, a_form);
+        Manager::GetSingleton()->QueueDelta(a_form);
+    }
+
+    void MagicRemoveFavorite::thunk(RE::MagicFavorites* a_this, RE::TESForm* a_form) {
+        func(a_this, a_form);
+        Manager::GetSingleton()->QueueDelta(a_form);
+    }
+
+    bool ActorAddSpell::thunk(RE::Actor* a_this, RE::SpellItem* a_spell) {
+        const auto added = func(a_this, a_spell);
+        if (added && a_this == RE::PlayerCharacter::GetSingleton()) Manager::GetSingleton()->InvalidatePlayerSpells();
+        return added;
+    }
+
+    bool ActorRemoveSpell::thunk(RE::Actor* a_this, RE::SpellItem* a_spell) {
+        const auto removed = func(a_this, a_spell);
+        if (removed && a_this == RE::PlayerCharacter::GetSingleton()) Manager::GetSingleton()->InvalidatePlayerSpells();
+        return removed;
+    }
+
+    void Install() {
+        const auto manager = Manager::GetSingleton();
+        // the first n_favorite_hooks feed the delta stream, the rest the spell cache
+        constexpr std::size_t n_favorite_hooks = 4;
+        std::array hooks{Prepare<InventorySetFavorite>("InventoryChanges::SetFavorite"),
+                         Prepare<InventoryRemoveFavorite>("InventoryChanges::RemoveFavorite"),
+                         Prepare<MagicSetFavorite>("MagicFavorites::SetFavorite"),
+                         Prepare<MagicRemoveFavorite>("MagicFavorites::RemoveFavorite"),
+                         Prepare<ActorAddSpell>("Actor::AddSpell"),
+                         Prepare<ActorRemoveSpell>("Actor::RemoveSpell")};
+
+        std::size_t n_sites = 0;
+        for (const auto& hook : hooks) n_sites += hook.call_sites.size();
+        // a 5-byte call through the trampoline takes 14 bytes of it
+        SKSE::AllocTrampoline(std::max<std::size_t>(n_sites * 14, 14));
+
+        const auto install = [](PendingHook& hook) {
+            // the thunks call the original directly
+            hook.set_func(hook.target);
+            if (hook.call_sites.empty()) {
+                logger::warn("No call sites listed for hook {} on this runtime.", hook.name);
+                return false;
+            }
+            for (const auto call_site : hook.call_sites) {
+                if (IsCallTo(call_site, hook.target)) continue;
+                logger::error("Call site {:x} of hook {} does not call it. Hook not installed.", call_site, hook.name);
+                return false;
+            }
+            for (const auto call_site : hook.call_sites) {
+                SKSE::GetTrampoline().write_call<5>(call_site, hook.thunk);
+            }
+            logger::info("Installed hook: {} at {} call sites", hook.name, hook.call_sites.size());
+            return true;
+        };
+
+        bool favorites_hooked = true;
+        for (std::size_t i = 0; i < n_favorite_hooks; i++) favorites_hooked &= install(hooks[i]);
+        if (favorites_hooked) manager->EnableDeltaTracking();
+        else logger::warn("Favorite hooks not installed. Falling back to full favorites sync.");
+
+        bool spells_hooked = true;
+        for (std::size_t i = n_favorite_hooks; i < hooks.size(); i++) spells_hooked &= install(hooks[i]);
+        if (spells_hooked) manager->EnableSpellCache();
+        else logger::warn("Spell hooks not installed. Player spells will be collected on every pass.");
+    }
+};
@@ -1,10 +1,7 @@
 #include "Manager.h"
 
-
 const bool Manager::RemoveFavorite(const FormID formid) {
-	const auto removed = favorites.erase(formid);
-	hotkey_map.erase(formid);
-    return removed;
+    return reconciler.Erase(formid);
 };
 const int Manager::GetHotkey(const RE::InventoryEntryData* a_entry) const { 
     if (!a_entry) {
@@ -24,7 +21,7 @@ const int Manager::GetHotkey(const RE::InventoryEntryData* a_entry) const {
         if (extraList->HasType(RE::ExtraDataType::kHotkey)) {
             const auto hotkey = extraList->GetByType<RE::ExtraHotkey>()->hotkey.underlying();
             if (!IsHotkeyValid(hotkey)) continue;
-            logger::trace("GetHotkey: Hotkey found: {}", hotkey);
+            LOG_TRACE("GetHotkey: Hotkey found: {}", hotkey);
             return hotkey;
         }
     }
@@ -32,45 +29,21 @@ const int Manager::GetHotkey(const RE::InventoryEntryData* a_entry) const {
 }
 
 const inline bool Manager::IsHotkeyValid(const int hotkey) const { 
-    return allowed_hotkeys.contains(hotkey);
+    return hotkey >= 0 && hotkey < static_cast<int>(HotkeySlots::n_slots);
 }
 
 void Manager::UpdateHotkeyMap(const FormID item_formid, const RE::InventoryEntryData* a_entry) {
-    const auto hotkey = GetHotkey(a_entry);
-    if (IsHotkeyValid(hotkey)) {
-        logger::trace("Hotkey found. FormID: {:x}, Hotkey: {}", item_formid, hotkey);
-        hotkey_map[item_formid] = hotkey;
-    }
+    using namespace Utils::FunctionsSkyrim::Inventory;
+    m_Data.SetInstance(item_formid, GetInstanceFingerprint(GetFavoritedList(a_entry)));
+    reconciler.RecordHotkey(item_formid, GetHotkey(a_entry));
 }
 
 void Manager::UpdateHotkeyMap(const FormID spell_formid, const int a_hotkey) {
-    if (IsHotkeyValid(a_hotkey)) {
-		logger::trace("Hotkey found. FormID: {:x}, Hotkey: {}", spell_formid, a_hotkey);
-		hotkey_map[spell_formid] = a_hotkey;
-	}
-}
-
-const std::map<unsigned int, FormID> Manager::GetInventoryHotkeys() const { 
-    std::map<unsigned int,FormID> hotkeys_in_use;
-    const auto player_inventory = RE::PlayerCharacter::GetSingleton()->GetInventory();
-    for (auto& item : player_inventory) {
-        if (!item.first) continue;
-        if (item.second.first <= 0) continue;
-        if (std::strlen(item.first->GetName()) == 0) continue;
-        if (!item.second.second) continue;
-        if (!item.second.second->extraLists || item.second.second->extraLists->empty()) continue;
-        if (!item.second.second->IsFavorited()) continue;
-        const auto hotkey_temp = GetHotkey(item.second.second.get());
-        if (IsHotkeyValid(hotkey_temp)) {
-            hotkeys_in_use[hotkey_temp] = item.first->GetFormID();
-            logger::trace("GetInventoryHotkeys: FormID: {:x}, Hotkey: {}", item.first->GetFormID(), hotkey_temp);
-        }
-    }
-    return hotkeys_in_use;
+    reconciler.RecordHotkey(spell_formid, a_hotkey);
 }
 
-const std::map<FormID,unsigned int> Manager::GetMagicHotkeys() const { 
-    std::map<FormID,unsigned int> hotkeys_in_use;
+const std::pmr::map<FormID,unsigned int> Manager::GetMagicHotkeys() const { 
+    std::pmr::map<FormID,unsigned int> hotkeys_in_use(EventArena::Get());
     const auto& mg_hotkeys = RE::MagicFavorites::GetSingleton()->hotkeys;
     unsigned int index = 0;
     for (auto& hotkeyed_spell : mg_hotkeys) {
@@ -80,38 +53,42 @@ const std::map<FormID,unsigned int> Manager::GetMagicHotkeys() const {
 		}
         if (IsHotkeyValid(index)) {
             hotkeys_in_use[hotkeyed_spell->GetFormID()] = index;
-            logger::trace("GetMagicHotkeys: FormID: {:x}, Hotkey: {}", hotkeyed_spell->GetFormID(), index);
+            LOG_TRACE("GetMagicHotkeys: FormID: {:x}, Hotkey: {}", hotkeyed_spell->GetFormID(), index);
         }
 		index++;
 	}
 	return hotkeys_in_use;
 };
 
-const std::map<unsigned int,FormID> Manager::GetHotkeysInUse() const {
-    const auto& inventory_hotkeys = GetInventoryHotkeys();
-    const auto& magic_hotkeys = GetMagicHotkeys();
-    std::map<unsigned int, FormID> hotkeys_in_use;
-    for (const auto& [hotkey, form_id] : inventory_hotkeys) {
-        if (IsHotkeyValid(hotkey)) hotkeys_in_use[hotkey]=form_id;
+std::array<FormID, HotkeySlots::n_slots> Manager::SlotOwners() {
+    std::array<FormID, HotkeySlots::n_slots> owners{};
+    const auto player = RE::PlayerCharacter::GetSingleton();
+    // spell hotkeys are a plain 8-slot array in the game, so read them directly
+    const auto& mg_hotkeys = RE::MagicFavorites::GetSingleton()->hotkeys;
+    for (unsigned int slot = 0; slot < HotkeySlots::n_slots; slot++) {
+        if (slot < mg_hotkeys.size() && mg_hotkeys[slot]) {
+            owners[slot] = mg_hotkeys[slot]->GetFormID();
+            continue;
+        }
+        const auto used_by = hotkey_slots.Owner(slot);
+        if (!used_by) continue;
+        // the owner may have left the inventory or lost the hotkey since it was recorded
+        const auto xList = Utils::FunctionsSkyrim::Inventory::GetFavoritedList(
+            Utils::FunctionsSkyrim::Inventory::FindEntry(used_by, player));
+        if (SkyrimBackend::GetHotkey(xList) != static_cast<int>(slot)) {
+            LOG_TRACE("Hotkey {} released by {:x}", slot, used_by);
+            hotkey_slots.Release(used_by);
+            continue;
+        }
+        owners[slot] = used_by;
     }
-    for (const auto& [form_id,hotkey] : magic_hotkeys) {
-		if (IsHotkeyValid(hotkey)) hotkeys_in_use[hotkey]=form_id;
-	}
-    return hotkeys_in_use;
-};
+    return owners;
+}
 
-const FormID Manager::HotkeyIsInUse(const FormID formid, const int a_hotkey) const {
-    if (!IsHotkeyValid(a_hotkey)) {
-        logger::error("Hotkey invalid. Hotkey: {}", a_hotkey);
-        return formid;
-    }
-    const auto hotkeys_temp = GetHotkeysInUse();
-    if (const auto u_hotkey = static_cast<unsigned int>(a_hotkey); hotkeys_temp.contains(u_hotkey)) {
-        const auto used_by = hotkeys_temp.at(u_hotkey);
-        logger::trace("Hotkey {} in use by {}", a_hotkey, used_by);
-        return used_by;
-	}
-    return formid;
+const bool Manager::HoldsFavorite(const FormID formid) {
+    if (backend.IsSpellFavorited(formid)) return true;
+    const auto entry = Utils::FunctionsSkyrim::Inventory::FindEntry(formid, RE::PlayerCharacter::GetSingleton());
+    return Utils::FunctionsSkyrim::Inventory::GetFavoritedList(entry) != nullptr;
 }
 
 void Manager::HotkeySpell(RE::TESForm* form, const unsigned int hotkey) {
@@ -126,11 +103,13 @@ void Manager::HotkeySpell(RE::TESForm* form, const unsigned int hotkey) {
     for (auto& hotkeyed_spell : hotkeys) {
         if (!hotkeyed_spell && index == hotkey) {
             hotkeyed_spell = form;
-            logger::trace("HotkeySpell: Hotkey set. FormID: {:x}, Hotkey: {}", form->GetFormID(), hotkey);
+            hotkey_slots.Assign(form->GetFormID(), index);
+            LOG_TRACE("HotkeySpell: Hotkey set. FormID: {:x}, Hotkey: {}", form->GetFormID(), hotkey);
             return;
         }
         else if (hotkeyed_spell && hotkeyed_spell->GetFormID() == form->GetFormID()) {
-			logger::trace("HotkeySpell: Hotkey already set. FormID: {:x}, Hotkey: {}", form->GetFormID(), hotkey);
+            hotkey_slots.Assign(form->GetFormID(), index);
+			LOG_TRACE("HotkeySpell: Hotkey already set. FormID: {:x}, Hotkey: {}", form->GetFormID(), hotkey);
 			return;
 		}
         index++;
@@ -140,94 +119,116 @@ void Manager::HotkeySpell(RE::TESForm* form, const unsigned int hotkey) {
 }
 
 void Manager::ApplyHotkey(const FormID formid) {
-    if (!formid) return;
-    if (!favorites.contains(formid)) {
-        logger::trace("ApplyHotkey: Form not favorited. FormID: {:x}", formid);
-        return;
-    }
-    if (!hotkey_map.contains(formid)) {
-        logger::trace("ApplyHotkey: Hotkey not found. FormID: {:x}", formid);
-        return;
-    }
-    const auto hotkey = hotkey_map.at(formid);
-    if (!IsHotkeyValid(hotkey)) {
-        logger::error("Hotkey invalid. FormID: {:x}, Hotkey: {}", formid, hotkey);
-        hotkey_map.erase(formid);
-		return;
+    CommitHotkeys({&formid, 1});
+}
+
+void Manager::CommitHotkeys(std::span<const FormID> formids) {
+    ENABLE_IF_NOT_UNINSTALLED
+    backend.MirrorFavoritedSpells();
+    std::pmr::vector<std::pair<FormID, unsigned int>> wanted(EventArena::Get());
+    for (const auto formid : formids) {
+        if (!formid || !m_Data.Contains(formid)) continue;
+        const auto hotkey = m_Data.GetHotkey(formid);
+        if (hotkey < 0) continue;
+        if (!IsHotkeyValid(hotkey)) {
+            logger::error("Hotkey invalid. FormID: {:x}, Hotkey: {}", formid, hotkey);
+            m_Data.SetHotkey(formid, -1);
+            continue;
+        }
+        // only forms the game shows as favorites can carry a hotkey; the rest would claim slots they never use
+        if (!HoldsFavorite(formid)) continue;
+        wanted.emplace_back(formid, static_cast<unsigned int>(hotkey));
     }
-    if (const auto used_by = HotkeyIsInUse(formid, hotkey); used_by != formid) {
-        logger::trace("Hotkey in use. FormID: {:x}, Hotkey: {}, used_by {:x}", formid, hotkey, used_by);
-		hotkey_map.erase(formid);
-        hotkey_map[used_by] = hotkey;
-        return;
+    if (wanted.empty()) return;
+
+    const auto owners = SlotOwners();
+    const auto plan = SolveHotkeys(std::move(wanted), owners);
+    for (const auto& [formid, slot] : plan.denied) {
+        LOG_TRACE("Hotkey in use. FormID: {:x}, Hotkey: {}, used_by {:x}", formid, slot, owners[slot]);
+        m_Data.SetHotkey(formid, -1);
+        // the batch's own winners are not owners yet, so only pre-existing owners take over the saved slot
+        if (owners[slot]) m_Data.SetHotkey(owners[slot], slot);
     }
+    for (const auto& [formid, slot] : plan.writes) WriteHotkey(formid, slot);
+    LOG_TRACE("CommitHotkeys: {} written, {} denied of {} forms.", plan.writes.size(), plan.denied.size(),
+              formids.size());
+}
+
+void Manager::WriteHotkey(const FormID formid, const unsigned int hotkey) {
     const auto spell = Utils::FunctionsSkyrim::GetFormByID<RE::SpellItem>(formid);
     if (spell && RE::PlayerCharacter::GetSingleton()->HasSpell(spell)) {
         HotkeySpell(spell, hotkey);
-		return;
+        return;
     }
-    else if (spell) {
-        logger::trace("Spell not found in player's spell list. FormID: {:x}", formid);
+    if (spell) {
+        LOG_TRACE("Spell not found in player's spell list. FormID: {:x}", formid);
     }
 
-    // Spell ended
-
     // Now items
     const auto bound = Utils::FunctionsSkyrim::GetFormByID<RE::TESBoundObject>(formid);
     if (!bound) {
-        logger::error("ApplyHotkey: Form not found. FormID: {:x}", formid);
+        logger::error("WriteHotkey: Form not found. FormID: {:x}", formid);
         return;
     }
-    const auto player_inventory = RE::PlayerCharacter::GetSingleton()->GetInventory();
-    const auto item = player_inventory.find(bound);
-    if (item == player_inventory.end()) {
-		logger::trace("ApplyHotkey: Item not found in inventory. FormID: {:x}", formid);
+    const auto player = RE::PlayerCharacter::GetSingleton();
+    const auto entry = Utils::FunctionsSkyrim::Inventory::FindEntry(formid, player);
+    if (!entry) {
+		LOG_TRACE("WriteHotkey: Item not found in inventory. FormID: {:x}", formid);
 		return;
 	}
-    auto* xList = item->second.second->extraLists->front();
+    if (!entry->extraLists || entry->extraLists->empty()) {
+        logger::error("WriteHotkey: Item has no extraLists. FormID: {:x}", formid);
+        return;
+    }
+    // the saved instance if it is still there, else whichever stack carries the favorite
+    auto* xList = Utils::FunctionsSkyrim::Inventory::FindInstance(formid, m_Data.GetInstance(formid), player);
+    if (!xList) xList = Utils::FunctionsSkyrim::Inventory::GetFavoritedList(entry);
+    if (!xList) xList = entry->extraLists->front();
     if (!xList) {
-		logger::error("ApplyHotkey: ExtraList is null. FormID: {:x}", formid);
+		logger::error("WriteHotkey: ExtraList is null. FormID: {:x}", formid);
 		return;
 	}
     if (xList->HasType(RE::ExtraDataType::kHotkey)) {
         auto* old_xHotkey = xList->GetByType<RE::ExtraHotkey>();
-        const auto old_hotkey = static_cast<int>(old_xHotkey->hotkey.get());
-        logger::trace("ApplyHotkey: Hotkey already exists. FormID: {:x}, old Hotkey: {}", formid, old_hotkey);
+        LOG_TRACE("WriteHotkey: Hotkey already exists. FormID: {:x}, old Hotkey: {}", formid,
+                  static_cast<int>(old_xHotkey->hotkey.get()));
         //old_xHotkey->hotkey.reset(static_cast<RE::ExtraHotkey::Hotkey>(hotkey));
         old_xHotkey->hotkey = static_cast<RE::ExtraHotkey::Hotkey>(hotkey);
     } else {
-        logger::trace("ApplyHotkey: Creating hotkey. FormID: {:x}, Hotkey: {}", formid, hotkey);
+        LOG_TRACE("WriteHotkey: Creating hotkey. FormID: {:x}, Hotkey: {}", formid, hotkey);
         RE::ExtraHotkey* xHotkey = RE::ExtraHotkey::Create<RE::ExtraHotkey>();
         if (!xHotkey) {
-            logger::error("ApplyHotkey: Failed to create hotkey. FormID: {:x}", formid);
+            logger::error("WriteHotkey: Failed to create hotkey. FormID: {:x}", formid);
             return;
         }
         xHotkey->hotkey = static_cast<RE::ExtraHotkey::Hotkey>(hotkey);
         if (static_cast<uint8_t>(xHotkey->hotkey.get()) != hotkey) {
-            logger::error("ApplyHotkey: Failed to set hotkey. FormID: {:x}, Hotkey: {}", formid, hotkey);
+            logger::error("WriteHotkey: Failed to set hotkey. FormID: {:x}, Hotkey: {}", formid, hotkey);
             delete xHotkey;
             return;
         }
-        logger::trace("ApplyHotkey: Adding hotkey. FormID: {:x}, Hotkey: {}", formid, hotkey);
+        LOG_TRACE("WriteHotkey: Adding hotkey. FormID: {:x}, Hotkey: {}", formid, hotkey);
         xList->Add(xHotkey);
     }
-    const int added_hotkey = GetHotkey(item->second.second.get());
+    const auto* added_xHotkey = xList->GetByType<RE::ExtraHotkey>();
+    const int added_hotkey = added_xHotkey ? static_cast<int>(added_xHotkey->hotkey.underlying()) : -1;
     if (added_hotkey != static_cast<int>(hotkey)) {
-        logger::error("ApplyHotkey: Failed to add hotkey. FormID: {:x}, Hotkey: {}, added:{}", formid, hotkey,
+        logger::error("WriteHotkey: Failed to add hotkey. FormID: {:x}, Hotkey: {}, added:{}", formid, hotkey,
                       added_hotkey);
 		return;
 	}
-    logger::trace("Hotkey applied. FormID: {:x}, Hotkey: {}", formid, hotkey);
+    hotkey_slots.Assign(formid, hotkey);
+    LOG_TRACE("Hotkey applied. FormID: {:x}, Hotkey: {}", formid, hotkey);
     
 }
 
 void Manager::SyncHotkeys_Item() {
     ENABLE_IF_NOT_UNINSTALLED
-    const auto player_inventory = RE::PlayerCharacter::GetSingleton()->GetInventory();
-    for (auto& item : player_inventory) {
+    const auto player_inventory = Utils::FunctionsSkyrim::Inventory::GetSnapshot(RE::PlayerCharacter::GetSingleton());
+    for (auto& item : *player_inventory) {
         if (!item.first) continue;
         if (item.second.first <= 0) continue;
-        if (std::strlen(item.first->GetName()) == 0) continue;
+        if (!form_cache->HasName(item.first)) continue;
         if (!item.second.second) continue;
         if (!item.second.second->extraLists || item.second.second->extraLists->empty()) continue;
         if (!item.second.second->IsFavorited()) continue;
@@ -241,7 +242,7 @@ void Manager::SyncHotkeys_Spell() {
     const auto mg_hotkeys = GetMagicHotkeys();
     for (auto& spell : mg_favorites) {
         if (!spell) continue;
-        if (std::strlen(spell->GetName()) == 0) continue;
+        if (!form_cache->HasName(spell)) continue;
         if (!mg_hotkeys.contains(spell->GetFormID())) continue;
         const auto spell_formid = spell->GetFormID();
         UpdateHotkeyMap(spell_formid, mg_hotkeys.at(spell_formid));
@@ -250,10 +251,98 @@ void Manager::SyncHotkeys_Spell() {
 
 void Manager::SyncHotkeys() {
     ENABLE_IF_NOT_UNINSTALLED
+    const Stats::ScopedTimer timer(Stats::Probe::kSyncHotkeys, m_Data.Size());
+    hotkey_slots.Clear();
 	SyncHotkeys_Item();
 	SyncHotkeys_Spell();
 }
 
+void Manager::SyncHotkeys_Delta() {
+    ENABLE_IF_NOT_UNINSTALLED
+    const Stats::ScopedTimer timer(Stats::Probe::kSyncHotkeys, m_Data.Size());
+    // ExtraHotkey has no setter to hook. Hotkeys are edited in the favorites menu, whose entries point at the live
+    // inventory entries, so only the favorites need to be looked at.
+    if (const auto favorites_menu = RE::UI::GetSingleton()->GetMenu<RE::FavoritesMenu>()) {
+        hotkey_slots.Clear();
+        for (const auto& entry : favorites_menu->favorites) {
+            if (!entry.item || !entry.entryData) continue;
+            if (!entry.entryData->IsFavorited()) continue;
+            UpdateHotkeyMap(entry.item->GetFormID(), entry.entryData);
+        }
+    }
+    SyncHotkeys_Spell();
+}
+
+void Manager::ApplyDeltas() {
+    ENABLE_IF_NOT_UNINSTALLED
+    {
+        Locker locker(delta_lock);
+        applied_deltas.swap(pending_deltas);
+    }
+    // a delta carries the whole state of its form, so only the last one per form counts
+    std::ranges::reverse(applied_deltas);
+    std::ranges::stable_sort(applied_deltas, {}, &FavoriteDelta::formid);
+    const auto [first, last] = std::ranges::unique(applied_deltas, {}, &FavoriteDelta::formid);
+    applied_deltas.erase(first, last);
+
+    // new favorites go in as one batch, before their hotkeys are mapped
+    std::pmr::vector<FavoritesTable::Row> favorited_rows(EventArena::Get());
+    for (const auto& [formid, favorited, hotkey, instance] : applied_deltas) {
+        if (!favorited || m_Data.Contains(formid)) continue;
+        favorited_rows.push_back({formid, -1, form_cache->GetEditorID(formid), instance});
+        LOG_TRACE("ApplyDeltas: Favorited. FormID: {:x}, Instance: {:x}", formid, instance);
+    }
+    m_Data.InsertRows(favorited_rows);
+
+    for (const auto& [formid, favorited, hotkey, instance] : applied_deltas) {
+        if (favorited) {
+            m_Data.SetInstance(formid, instance);
+            UpdateHotkeyMap(formid, hotkey);
+        } else if (RemoveFavorite(formid)) {
+            LOG_TRACE("ApplyDeltas: Erased. FormID: {:x}", formid);
+        }
+    }
+    // both buffers keep their capacity, so queueing deltas stops allocating once they have grown
+    applied_deltas.clear();
+}
+
+void Manager::QueueDelta(const RE::InventoryEntryData* a_entry, const RE::ExtraDataList* a_itemList) {
+    using namespace Utils::FunctionsSkyrim::Inventory;
+    if (!delta_tracking || isUninstalled) return;
+    if (!a_entry || !a_entry->object) return;
+    if (!form_cache->HasName(a_entry->object)) return;
+    const auto favorited = a_entry->IsFavorited();
+    const auto hotkey = favorited ? GetHotkey(a_entry) : -1;
+    if (!a_itemList || !a_itemList->HasType(RE::ExtraDataType::kHotkey)) a_itemList = GetFavoritedList(a_entry);
+    const auto instance = favorited ? GetInstanceFingerprint(a_itemList) : FavoritesTable::any_instance;
+    Locker locker(delta_lock);
+    pending_deltas.push_back({a_entry->object->GetFormID(), favorited, hotkey, instance});
+    delta_revision++;
+}
+
+void Manager::QueueDelta(const RE::TESForm* a_spell) {
+    if (!delta_tracking || isUninstalled) return;
+    if (!a_spell || !a_spell->As<RE::SpellItem>()) return;
+    if (!form_cache->HasName(a_spell)) return;
+    const auto spell_formid = a_spell->GetFormID();
+    const auto mg_favorites = RE::MagicFavorites::GetSingleton();
+    const auto favorited = IsSpellFavorited(spell_formid, mg_favorites->spells);
+    int hotkey = -1;
+    if (favorited) {
+        int index = 0;
+        for (const auto& hotkeyed_spell : mg_favorites->hotkeys) {
+            if (hotkeyed_spell && hotkeyed_spell->GetFormID() == spell_formid) {
+                hotkey = index;
+                break;
+            }
+            index++;
+        }
+    }
+    Locker locker(delta_lock);
+    pending_deltas.push_back({spell_formid, favorited, hotkey, FavoritesTable::any_instance});
+    delta_revision++;
+}
+
 const bool Manager::IsSpellFavorited(const FormID a_spell, const RE::BSTArray<RE::TESForm*>& favs) const {
     for (auto& fav : favs) {
 		if (!fav) continue;
@@ -262,146 +351,154 @@ const bool Manager::IsSpellFavorited(const FormID a_spell, const RE::BSTArray<RE
 	return false;
 }
 
-RE::BSContainer::ForEachResult Manager::Visit(RE::SpellItem* a_spell) {
-    if (!a_spell) return RE::BSContainer::ForEachResult::kContinue;
-    if (std::strlen(a_spell->GetName()) == 0) return RE::BSContainer::ForEachResult::kContinue;
-    temp_all_spells.insert(a_spell->GetFormID());
-    return RE::BSContainer::ForEachResult::kContinue;
-}
-
-void Manager::CollectPlayerSpells() {
-    temp_all_spells.clear();
-    const auto player = RE::PlayerCharacter::GetSingleton(); 
-    player->VisitSpells(*this);
-}
-
 void Manager::AddFavorites_Item() {
     ENABLE_IF_NOT_UNINSTALLED
-    const auto player = RE::PlayerCharacter::GetSingleton();
-    const auto player_inventory = player->GetInventory();
-    for (auto& item : player_inventory) {
-        if (!item.first) continue;
-        if (item.second.first <= 0) continue;
-        if (std::strlen(item.first->GetName()) == 0) continue;
-        if (!item.second.second) continue;
-        if (item.second.second->IsFavorited()) {
-            if (favorites.insert(item.first->GetFormID()).second) {
-                logger::trace("Item favorited. FormID: {:x}, EditorID: {}", item.first->GetFormID(),
-                              clib_util::editorID::get_editorID(item.first));
-            }
-            UpdateHotkeyMap(item.first->GetFormID(), item.second.second.get());
-        } else if (favorites.contains(item.first->GetFormID())) {
-            Utils::FunctionsSkyrim::Inventory::FavoriteItem(item.first, player);
-            ApplyHotkey(item.first->GetFormID());
-        }
-    }
+    CommitHotkeys(reconciler.RestoreItems());
 }
 
 void Manager::AddFavorites_Spell() {
     ENABLE_IF_NOT_UNINSTALLED
-    
-    const auto mg_favorites = RE::MagicFavorites::GetSingleton();
-    const auto& favorited_spells = mg_favorites->spells;
-    const auto hotkeyed_spells = GetMagicHotkeys();
-    CollectPlayerSpells();
-    if (temp_all_spells.empty()) {
-        logger::warn("AddFavorites: No spells found.");
-        return;
-    }
-    for (auto& spell_formid : temp_all_spells) {
-        const auto spell = Utils::FunctionsSkyrim::GetFormByID(spell_formid);
-        if (!spell) continue;
-        //logger::trace("Player has spell: {}", spell->GetName());
-        if (IsSpellFavorited(spell_formid, favorited_spells)) {
-            if (favorites.insert(spell_formid).second) {
-                logger::trace("Spell favorited. FormID: {:x}, EditorID: {}", spell_formid,
-                              clib_util::editorID::get_editorID(spell));
+    CommitHotkeys(reconciler.RestoreSpells());
+}
+
+std::uint64_t Manager::StateFingerprint() {
+    // FNV-1a over 32-bit words
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](const std::uint32_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    mix(static_cast<std::uint32_t>(m_Data.Revision()));
+    mix(static_cast<std::uint32_t>(backend.GetPlayerSpells().size()));
+
+    if (delta_tracking) {
+        // the hooks report every favorite change and container events every change to the player's items
+        std::uint64_t revision;
+        {
+            Locker locker(delta_lock);
+            revision = delta_revision;
+        }
+        mix(static_cast<std::uint32_t>(revision));
+        mix(static_cast<std::uint32_t>(revision >> 32));
+        mix(inventory_revision.load(std::memory_order_relaxed));
+    } else if (const auto inventory_changes = RE::PlayerCharacter::GetSingleton()->GetInventoryChanges();
+               inventory_changes && inventory_changes->entryList) {
+        std::uint32_t n_entries = 0;
+        for (const auto* entry : *inventory_changes->entryList) {
+            if (!entry || !entry->object) continue;
+            n_entries++;
+            mix(entry->object->GetFormID());
+            mix(static_cast<std::uint32_t>(entry->countDelta));
+            if (!entry->extraLists) continue;
+            for (const auto* xList : *entry->extraLists) {
+                const auto xHotkey = xList ? xList->GetByType<RE::ExtraHotkey>() : nullptr;
+                // favorited lists carry an ExtraHotkey, unbound or not
+                if (xHotkey) mix(0x100u | static_cast<std::uint8_t>(xHotkey->hotkey.underlying()));
             }
-            if (hotkeyed_spells.contains(spell_formid)) UpdateHotkeyMap(spell_formid, hotkeyed_spells.at(spell_formid));
-        } else if (favorites.contains(spell_formid)) {
-            mg_favorites->SetFavorite(spell);
-            ApplyHotkey(spell_formid);
         }
+        mix(n_entries);
     }
-    temp_all_spells.clear();
+
+    const auto mg_favorites = RE::MagicFavorites::GetSingleton();
+    mix(static_cast<std::uint32_t>(mg_favorites->spells.size()));
+    for (const auto* spell : mg_favorites->spells) mix(spell ? spell->GetFormID() : 0);
+    for (const auto* spell : mg_favorites->hotkeys) mix(spell ? spell->GetFormID() : 0);
+    return hash ? hash : 1;
 }
 
-void Manager::AddFavorites() {
-    ENABLE_IF_NOT_UNINSTALLED
-    AddFavorites_Item();
-    AddFavorites_Spell();
+bool Manager::AddFavorites() {
+    if (isUninstalled) return false;
+    Stats::ScopedTimer timer(Stats::Probe::kAddFavorites);
+    EnsureRestored();
+    ApplyDeltas();
+    // menu hopping reopens the same menus over unchanged state
+    if (StateFingerprint() == reconciled_fingerprint) {
+        LOG_TRACE("AddFavorites: Nothing changed since the last pass.");
+        return false;
+    }
+    hotkey_slots.Clear();
+    // items and spells share the 8 slots, so their hotkeys are solved as one batch
+    auto restored = reconciler.RestoreItems();
+    std::ranges::copy(reconciler.RestoreSpells(), std::back_inserter(restored));
+    CommitHotkeys(restored);
+    // the restores above changed the state, so fingerprint what they left behind
+    reconciled_fingerprint = StateFingerprint();
+    timer.SetItems(m_Data.Size());
+    return true;
 }
 
 void Manager::SyncFavorites_Item(){
     ENABLE_IF_NOT_UNINSTALLED
-    const auto player_inventory = RE::PlayerCharacter::GetSingleton()->GetInventory();
-    for (auto& item : player_inventory) {
-        if (!item.first) continue;
-        if (item.second.first <= 0) continue;
-        if (std::strlen(item.first->GetName()) == 0) continue;
-        if (!item.second.second) continue;
-        if (item.second.second->IsFavorited()) {
-            if (favorites.insert(item.first->GetFormID()).second) {
-                logger::trace("Item favorited. FormID: {:x}, EditorID: {}", item.first->GetFormID(),
-                              clib_util::editorID::get_editorID(item.first));
-            }
-            UpdateHotkeyMap(item.first->GetFormID(), item.second.second.get());
-        } else if (RemoveFavorite(item.first->GetFormID())) {
-            logger::trace("Item erased. FormID: {:x}, EditorID: {}", item.first->GetFormID(),
-                          clib_util::editorID::get_editorID(item.first));
-        }
-    }
+    reconciler.RecordItems(true);
 }
 
 void Manager::SyncFavorites_Spell(){
     ENABLE_IF_NOT_UNINSTALLED
-    const auto& favorited_spells = RE::MagicFavorites::GetSingleton()->spells;
-    const auto hotkeyed_spells = GetMagicHotkeys();
-    CollectPlayerSpells();
-    if (temp_all_spells.empty()) {
-        logger::warn("SyncFavorites: No spells found.");
-        return;
-    }
-    for (auto& spell_formid : temp_all_spells) {
-        const auto spell = Utils::FunctionsSkyrim::GetFormByID(spell_formid);
-        if (!spell) continue;
-        logger::trace("Player has spell: {}", spell->GetName());
-        if (IsSpellFavorited(spell_formid, favorited_spells)) {
-            if (favorites.insert(spell_formid).second) {
-                logger::trace("Spell favorited. FormID: {:x}, EditorID: {}", spell_formid,
-                              clib_util::editorID::get_editorID(spell));
-            }
-            if (hotkeyed_spells.contains(spell_formid)) UpdateHotkeyMap(spell_formid, hotkeyed_spells.at(spell_formid));
-        } else if (RemoveFavorite(spell_formid)) {
-            logger::trace("Spell erased. FormID: {:x}, EditorID: {}", spell_formid,
-                          clib_util::editorID::get_editorID(spell));
-        }
-    }
-    temp_all_spells.clear();
+    reconciler.RecordSpells(true);
 };
 
-void Manager::SyncFavorites() {
+void Manager::SyncFavorites(const bool a_full) {
     ENABLE_IF_NOT_UNINSTALLED
+    Stats::ScopedTimer timer(Stats::Probe::kSyncFavorites);
+    EnsureRestored();
+    if (delta_tracking) {
+        ApplyDeltas();
+        if (!a_full) {
+            SyncHotkeys_Delta();
+            timer.SetItems(m_Data.Size());
+            return;
+        }
+    }
     SyncFavorites_Item();
     SyncFavorites_Spell();
+    timer.SetItems(m_Data.Size());
 }
 
 void Manager::FavoriteCheck_Item(const FormID formid) {
     ENABLE_IF_NOT_UNINSTALLED
-    if (!favorites.contains(formid)) return;
+    EnsureRestored();
+    if (!m_Data.Contains(formid)) return;
     const auto bound = Utils::FunctionsSkyrim::GetFormByID<RE::TESBoundObject>(formid);
     if (!bound) {
         logger::warn("FavoriteCheck_Item: Form not found. FormID: {}", formid);
         RemoveFavorite(formid);
         return;
     }
-    Utils::FunctionsSkyrim::Inventory::FavoriteItem(bound, RE::PlayerCharacter::GetSingleton());
-    ApplyHotkey(bound->GetFormID());
+    const Utils::FunctionsSkyrim::Inventory::Instance instance{formid, m_Data.GetInstance(formid)};
+    Utils::FunctionsSkyrim::Inventory::FavoriteItems({&instance, 1}, RE::PlayerCharacter::GetSingleton());
+    ApplyHotkey(formid);
+}
+
+void Manager::FavoriteCheck_Items(std::pmr::vector<FormID>& formids) {
+    ENABLE_IF_NOT_UNINSTALLED
+    EnsureRestored();
+    std::ranges::sort(formids);
+    const auto [first, last] = std::ranges::unique(formids);
+    formids.erase(first, last);
+
+    std::pmr::vector<Utils::FunctionsSkyrim::Inventory::Instance> to_restore(EventArena::Get());
+    for (const auto formid : formids) {
+        if (!m_Data.Contains(formid)) continue;
+        const auto bound = Utils::FunctionsSkyrim::GetFormByID<RE::TESBoundObject>(formid);
+        if (!bound) {
+            logger::warn("FavoriteCheck_Items: Form not found. FormID: {}", formid);
+            RemoveFavorite(formid);
+            continue;
+        }
+        to_restore.push_back({formid, m_Data.GetInstance(formid)});
+    }
+    if (to_restore.empty()) return;
+    LOG_TRACE("FavoriteCheck_Items: Restoring {} of {} items.", to_restore.size(), formids.size());
+    Utils::FunctionsSkyrim::Inventory::FavoriteItems(to_restore, RE::PlayerCharacter::GetSingleton());
+    std::pmr::vector<FormID> restored(EventArena::Get());
+    restored.reserve(to_restore.size());
+    for (const auto& instance : to_restore) restored.push_back(instance.formid);
+    CommitHotkeys(restored);
 }
 
 void Manager::FavoriteCheck_Spell(const FormID formid){
-    if (!favorites.contains(formid)) {
-        logger::trace("FavoriteCheck_Spell: Form not favorited. FormID: {:x}", formid);
+    if (!m_Data.Contains(formid)) {
+        LOG_TRACE("FavoriteCheck_Spell: Form not favorited. FormID: {:x}", formid);
         return;
     }
     const auto spell = Utils::FunctionsSkyrim::GetFormByID(formid);
@@ -410,108 +507,296 @@ void Manager::FavoriteCheck_Spell(const FormID formid){
 		RemoveFavorite(formid);
 		return;
 	}
-    logger::trace("FavoriteCheck_Spell: Favoriting spell. FormID: {:x}, EditorID: {}", formid, clib_util::editorID::get_editorID(spell));
+    LOG_TRACE("FavoriteCheck_Spell: Favoriting spell. FormID: {:x}, EditorID: {}", formid, form_cache->GetEditorID(spell));
     RE::MagicFavorites::GetSingleton()->SetFavorite(spell);
-    logger::trace("FavoriteCheck_Spell: Applying hotkey. FormID: {:x}", formid);
-    logger::info("spell name {}", spell->GetName());
+    LOG_TRACE("FavoriteCheck_Spell: Applying hotkey. FormID: {:x}", formid);
+    LOG_TRACE("spell name {}", spell->GetName());
 	ApplyHotkey(formid);
 };
 
+void Manager::FavoriteCheck_Spells(std::pmr::vector<FormID>& formids) {
+    ENABLE_IF_NOT_UNINSTALLED
+    EnsureRestored();
+    std::ranges::sort(formids);
+    const auto [first, last] = std::ranges::unique(formids);
+    formids.erase(first, last);
+
+    const auto mg_favorites = RE::MagicFavorites::GetSingleton();
+    backend.MirrorFavoritedSpells();
+    std::pmr::vector<FormID> restored(EventArena::Get());
+    for (const auto formid : formids) {
+        if (!m_Data.Contains(formid)) continue;
+        const auto spell = Utils::FunctionsSkyrim::GetFormByID(formid);
+        if (!spell) {
+            logger::warn("FavoriteCheck_Spells: Form not found. FormID: {}", formid);
+            RemoveFavorite(formid);
+            continue;
+        }
+        if (!backend.IsSpellFavorited(formid)) mg_favorites->SetFavorite(spell);
+        restored.push_back(formid);
+    }
+    CommitHotkeys(restored);
+    LOG_TRACE("FavoriteCheck_Spells: Restored {} of {} spells.", restored.size(), formids.size());
+}
+
 void Manager::FavoriteCheck_Spell(){
-    CollectPlayerSpells();
-    if (temp_all_spells.empty()) {
+    EnsureRestored();
+    const auto& all_spells = backend.GetPlayerSpells();
+    if (all_spells.empty()) {
 		logger::warn("FavoriteCheck_Spell: No spells found.");
 		return;
 	}
-    for (auto& spell_formid : temp_all_spells) {
-        FavoriteCheck_Spell(spell_formid);
-    }
-    temp_all_spells.clear();
+    std::pmr::vector<FormID> formids(all_spells.begin(), all_spells.end(), EventArena::Get());
+    FavoriteCheck_Spells(formids);
 };
 
+void Manager::TrackReference(const RefID refid) {
+    ENABLE_IF_NOT_UNINSTALLED
+    const EventArena::Scope arena_scope;
+    const Utils::FunctionsSkyrim::Inventory::SnapshotScope snapshot_scope;
+    actor_shards.Track(refid);
+    actor_shards.Publish();
+}
+
+void Manager::UntrackReference(const RefID refid) {
+    ENABLE_IF_NOT_UNINSTALLED
+    actor_shards.Untrack(refid);
+    actor_shards.Publish();
+}
+
+void Manager::FavoriteCheck_References() {
+    ENABLE_IF_NOT_UNINSTALLED
+    if (const auto n_restored = actor_shards.Drain()) {
+        LOG_TRACE("FavoriteCheck_References: Restored {} items.", n_restored);
+    }
+}
+
+void Manager::AddFavorites_Reference(const RefID refid) {
+    ENABLE_IF_NOT_UNINSTALLED
+    if (!refid || refid == player_refid) return;
+    if (actor_shards.IsTracked(refid)) {
+        actor_shards.Restore(refid);
+        return;
+    }
+    const auto actor = RE::TESForm::LookupByID<RE::Actor>(refid);
+    if (actor && actor->IsPlayerTeammate()) actor_shards.Track(refid);
+}
+
+void Manager::SyncFavorites_Reference(const RefID refid) {
+    ENABLE_IF_NOT_UNINSTALLED
+    if (actor_shards.IsTracked(refid)) actor_shards.Record(refid);
+}
+
 void Manager::Reset() {
     ENABLE_IF_NOT_UNINSTALLED
     logger::info("Resetting manager...");
-    favorites.clear();
-    hotkey_map.clear();
+    hotkey_slots.Clear();
+    InvalidatePlayerSpells();
+    // the loaded save brings its own inventory entries
+    Utils::FunctionsSkyrim::Inventory::InvalidateEntryIndex();
+    DiscardDecode();
+    actor_shards.Clear();
+    restore = {};
+    profile_id = 0;
+    reconciled_fingerprint = 0;
+    form_cache->ClearDynamic();
+    {
+        Locker locker(delta_lock);
+        pending_deltas.clear();
+    }
     Clear();
+    Publish();
     logger::info("Manager reset.");
 };
 
 void Manager::SendData() {
     ENABLE_IF_NOT_UNINSTALLED
-    // std::lock_guard<std::mutex> lock(mutex);
     logger::info("--------Sending data---------");
-    Clear();
+    if (restore.pending || !restore.collected) {
+        // the table does not hold the saved favorites yet, and writing it would wipe the profile
+        logger::warn("SendData: Restore not finished. The profile is left as it is.");
+        return;
+    }
+    // only the published snapshot is read here, unresolved rows are dropped by Save
+    const auto data = GetSnapshot();
+    if (const auto store = ProfileStore::GetSingleton(); store->IsOpen()) {
+        store->Write(GetProfileID(), GetCharacterName(), *data);
+    }
+    logger::info("Data sent. Number of instances: {}, records: {}", data->Size(),
+                 std::max<std::size_t>(1, (data->Size() + Settings::chunk_size - 1) / Settings::chunk_size));
+}
 
-    int n_instances = 0;
-    for (auto& fav_id : favorites) {
-        const auto temp_form = Utils::FunctionsSkyrim::GetFormByID(fav_id);
-        if (!temp_form) continue;
-        const auto temp_editorid = clib_util::editorID::get_editorID(temp_form);
-        //if (temp_editorid.empty()) continue;
-        SaveDataLHS lhs({fav_id, temp_editorid});
-        const int rhs = hotkey_map.contains(fav_id) && IsHotkeyValid(hotkey_map.at(fav_id)) ? hotkey_map.at(fav_id) : -1;
-        SetData(lhs, rhs);
-        n_instances++;
-        if (n_instances >= Settings::instance_limit) {
-			logger::warn("SendData: Instance limit reached. Number of instances: {}", n_instances);
-			break;
-		}
+void Manager::MergeProfile() {
+    const auto store = ProfileStore::GetSingleton();
+    if (!store->IsOpen()) return;
+    const auto character = GetCharacterName();
+    const auto rows = store->Read(profile_id);
+    std::pmr::vector<FavoritesTable::Row> batch(EventArena::Get());
+    batch.reserve(rows.size());
+    for (const auto& row : rows) {
+        // FormIDs shift with the load order, so only rows that can be matched by editor ID are trusted
+        const auto editorid = ProfileStore::EditorID(row);
+        if (editorid.empty()) continue;
+        const auto hotkey = row.hotkey == FavoritesTable::no_hotkey ? -1 : row.hotkey;
+        batch.push_back({row.formid, hotkey, editorid});
     }
-    logger::info("Data sent. Number of instances: {}", n_instances);
+    const auto n_merged = m_Data.InsertRows(batch);
+    logger::info("ReceiveData: Merged {} favorites from the profile of {}.", n_merged, character);
 }
 
-void Manager::ReceiveData() {
+void Manager::ReceiveData(const bool a_cosave_found) {
     ENABLE_IF_NOT_UNINSTALLED
     logger::info("--------Receiving data---------");
-    if (m_Data.empty()) {
-        logger::warn("ReceiveData: No data to receive.");
-        return;
+    // only stage here; the cosave may still be decoding, and resolving forms and hotkeys would add to the load screen
+    restore = {};
+    restore.pending = true;
+    restore.collected = false;
+    restore.merge_profile = !a_cosave_found;
+};
+
+std::uint64_t Manager::GetProfileID() {
+    if (!profile_id) {
+        std::random_device device;
+        while (!profile_id) profile_id = std::uint64_t{device()} << 32 | device();
+        logger::info("New profile id {:x} for {}.", profile_id, GetCharacterName());
+    }
+    return profile_id;
+}
+
+bool Manager::SaveProfileID(SKSE::SerializationInterface* serializationInterface) {
+    const auto id = GetProfileID();
+    if (!serializationInterface->OpenRecord(Settings::kProfileKey, Settings::kSerializationVersion)) {
+        logger::error("Failed to open record for the profile id");
+        return false;
+    }
+    return serializationInterface->WriteRecordData(&id, sizeof(id));
+}
+
+bool Manager::LoadProfileID(SKSE::SerializationInterface* serializationInterface, const std::uint32_t length) {
+    std::uint64_t id = 0;
+    if (length != sizeof(id) || serializationInterface->ReadRecordData(&id, sizeof(id)) != sizeof(id) || !id) {
+        return false;
     }
+    profile_id = id;
+    return true;
+}
 
-    int n_instances = 0;
-    for (const auto& [lhs, rhs] : m_Data) {
+void Manager::CollectStaged() {
+    if (restore.collected) return;
+    restore.collected = true;
+    FinishDecode();
+    if (restore.merge_profile) MergeProfile();
+    if (m_Data.Empty()) logger::warn("ReceiveData: No data to receive.");
+    else logger::info("Data staged. Number of records: {}", m_Data.Size());
+}
+
+const bool Manager::ResolveStaged(const std::size_t max_rows) {
+    // records are resolved in place; rows whose form moved or vanished are fixed up in FinishRestore
+    const auto end_row = std::min(m_Data.Size(), restore.next_row + max_rows);
+    for (auto& row = restore.next_row; row < end_row; row++) {
         
-        auto source_formid = lhs.first;
-        auto source_editorid = lhs.second;
+        const auto source_formid = m_Data.FormIDAt(row);
+        const auto& source_editorid = m_Data.EditorIDAt(row);
 
         if (!source_formid) {
             logger::error("ReceiveData: Formid is null.");
+            restore.unresolved.push_back(source_formid);
             continue;
         }
-        //if (source_editorid.empty()) {
-        //    logger::error("ReceiveData: Editorid is empty.");
-        //    continue;
-        //}
         const auto source_form = Utils::FunctionsSkyrim::GetFormByID(source_formid, source_editorid);
         if (!source_form) {
             logger::critical("ReceiveData: Source form not found. Saved formid: {}, editorid: {}", source_formid,
                              source_editorid);
+            restore.unresolved.push_back(source_formid);
             continue;
         }
+        if (!IsHotkeyValid(m_Data.HotkeyAt(row))) m_Data.SetHotkey(source_formid, -1);
         if (source_form->GetFormID() != source_formid) {
             logger::warn("ReceiveData: Source formid does not match. Saved formid: {}, editorid: {}", source_formid,
                          source_editorid);
-            source_formid = source_form->GetFormID();
+            restore.moved.emplace_back(source_formid, source_form->GetFormID(), source_editorid);
+            continue;
         }
         if (source_editorid.empty()) {
-			source_editorid = clib_util::editorID::get_editorID(source_form);
+            m_Data.SetEditorID(source_formid, form_cache->GetEditorID(source_form));
 		}
 
-        if (favorites.contains(source_formid)) {
-			logger::warn("ReceiveData: Form already favorited. FormID: {}, EditorID: {}", source_formid, source_editorid);
-			continue;
-        }
-        else favorites.insert(source_formid);
-
-        if (IsHotkeyValid(rhs)) hotkey_map[source_formid] = rhs;
+		LOG_TRACE("FormID: {}, EditorID: {}", source_formid, m_Data.EditorIDAt(row));
+		restore.n_instances++;
+    }
+    return restore.next_row >= m_Data.Size();
+}
 
-		logger::info("FormID: {}, EditorID: {}", source_formid, source_editorid);
-		n_instances++;
+void Manager::FinishRestore() {
+    for (const auto formid : restore.unresolved) m_Data.Erase(formid);
+    for (const auto& [old_formid, new_formid, editorid] : restore.moved) {
+        const auto hotkey = m_Data.GetHotkey(old_formid);
+        const auto instance = m_Data.GetInstance(old_formid);
+        m_Data.Erase(old_formid);
+        if (!m_Data.Insert(new_formid, hotkey, editorid, instance)) {
+            logger::warn("ReceiveData: Form already favorited. FormID: {}, EditorID: {}", new_formid, editorid);
+            continue;
+        }
+        LOG_TRACE("FormID: {}, EditorID: {}", new_formid, editorid);
+        restore.n_instances++;
     }
+    const auto n_instances = restore.n_instances;
+    restore = {};
 
     SyncHotkeys();
+    // put the saved hotkeys the game lost back on the favorites it kept, all in one batch
+    std::pmr::vector<FormID> hotkeyed(EventArena::Get());
+    for (std::size_t row = 0; row < m_Data.Size(); row++) {
+        if (m_Data.HotkeyAt(row) >= 0) hotkeyed.push_back(m_Data.FormIDAt(row));
+    }
+    CommitHotkeys(hotkeyed);
+    Publish();
 
     logger::info("Data received. Number of instances: {}", n_instances);
-};
+}
+
+void Manager::RestoreStep() {
+    ENABLE_IF_NOT_UNINSTALLED
+    restore.scheduled = false;
+    if (!restore.pending) return;
+    Stats::ScopedTimer timer(Stats::Probe::kRestore);
+    const EventArena::Scope arena_scope;
+    const Utils::FunctionsSkyrim::Inventory::SnapshotScope snapshot_scope;
+    CollectStaged();
+    const auto first_row = restore.next_row;
+    const auto done = ResolveStaged(restore_batch);
+    timer.SetItems(restore.next_row - first_row);
+    if (done) FinishRestore();
+    else ScheduleRestore();
+}
+
+void Manager::ScheduleRestore() {
+    ENABLE_IF_NOT_UNINSTALLED
+    if (!restore.pending || restore.scheduled) return;
+    restore.scheduled = true;
+    SKSE::GetTaskInterface()->AddTask([this]() { RestoreStep(); });
+}
+
+void Manager::EnsureRestored() {
+    ENABLE_IF_NOT_UNINSTALLED
+    if (!restore.pending) return;
+    CollectStaged();
+    LOG_TRACE("EnsureRestored: Resolving {} remaining records.", m_Data.Size() - restore.next_row);
+    ResolveStaged(m_Data.Size());
+    FinishRestore();
+}
+
+void Manager::CompleteRestore() {
+    ENABLE_IF_NOT_UNINSTALLED
+    {
+        const EventArena::Scope arena_scope;
+        const Utils::FunctionsSkyrim::Inventory::SnapshotScope snapshot_scope;
+        EnsureRestored();
+    }
+    Publish();
+}
+
+void Manager::DumpToLog() {
+    CompleteRestore();
+    SaveLoadData::DumpToLog();
+}
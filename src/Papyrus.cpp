@@ -0,0 +1,42 @@
+#include "Papyrus.h"
+
+namespace Papyrus {
+
+    RE::BSFixedString GetStats(RE::StaticFunctionTag*) {
+        const auto summary = Stats::Summary();
+        return summary.c_str();
+    }
+
+    void DumpStats(RE::StaticFunctionTag*) {
+        // the count needs the restore finished, which only the game thread may do
+        SKSE::GetTaskInterface()->AddTask([]() { Manager::GetSingleton()->DumpToLog(); });
+    }
+
+    void ResetStats(RE::StaticFunctionTag*) {
+        Stats::Reset();
+        logger::info("Stats reset.");
+    }
+
+    void TrackReference(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref) {
+        if (!a_ref) return;
+        // scripts run off the game thread, and tracking reads the inventory
+        SKSE::GetTaskInterface()->AddTask(
+            [refid = a_ref->GetFormID()]() { Manager::GetSingleton()->TrackReference(refid); });
+    }
+
+    void UntrackReference(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref) {
+        if (!a_ref) return;
+        SKSE::GetTaskInterface()->AddTask(
+            [refid = a_ref->GetFormID()]() { Manager::GetSingleton()->UntrackReference(refid); });
+    }
+
+    bool Register(RE::BSScript::IVirtualMachine* vm) {
+        vm->RegisterFunction("GetStats", script_name, GetStats);
+        vm->RegisterFunction("DumpStats", script_name, DumpStats);
+        vm->RegisterFunction("ResetStats", script_name, ResetStats);
+        vm->RegisterFunction("TrackReference", script_name, TrackReference);
+        vm->RegisterFunction("UntrackReference", script_name, UntrackReference);
+        logger::info("Papyrus functions registered.");
+        return true;
+    }
+};
@@ -0,0 +1,174 @@
+#include "ProfileStore.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool ProfileStore::Open(const std::filesystem::path& path) {
+    if (IsOpen()) return true;
+#ifdef _WIN32
+    file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        logger::error("ProfileStore: Failed to open {}. Error: {}", path.string(), GetLastError());
+        return false;
+    }
+    // the mapping grows the file to file_size if it is shorter
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(file_size >> 32),
+                                 static_cast<DWORD>(file_size & 0xFFFFFFFF), nullptr);
+    if (mapping) view = static_cast<std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, file_size));
+    if (!view) {
+        logger::error("ProfileStore: Failed to map {}. Error: {}", path.string(), GetLastError());
+        Close();
+        return false;
+    }
+#else
+    file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        logger::error("ProfileStore: Failed to open {}. Error: {}", path.string(), errno);
+        return false;
+    }
+    if (::ftruncate(file, static_cast<off_t>(file_size)) != 0) {
+        logger::error("ProfileStore: Failed to size {}. Error: {}", path.string(), errno);
+        Close();
+        return false;
+    }
+    auto* mapped = ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED) {
+        logger::error("ProfileStore: Failed to map {}. Error: {}", path.string(), errno);
+        Close();
+        return false;
+    }
+    view = static_cast<std::uint8_t*>(mapped);
+#endif
+
+    auto* header = GetHeader();
+    if (header->magic != magic || header->version != layout_version || header->n_profiles != n_profiles ||
+        header->rows_per_profile != rows_per_profile) {
+        logger::info("ProfileStore: Initializing {}.", path.string());
+        std::memset(view, 0, file_size);
+        header->magic = magic;
+        header->version = layout_version;
+        header->n_profiles = n_profiles;
+        header->rows_per_profile = rows_per_profile;
+        Flush(view, view + file_size);
+    }
+    logger::info("ProfileStore: Opened {}.", path.string());
+    return true;
+}
+
+void ProfileStore::Close() {
+#ifdef _WIN32
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (view) ::munmap(view, file_size);
+    if (file >= 0) ::close(file);
+    file = -1;
+#endif
+    view = nullptr;
+}
+
+std::int64_t ProfileStore::FindSlot(const std::uint64_t key) const {
+    for (std::uint32_t slot = 0; slot < n_profiles; slot++) {
+        if (GetProfile(slot)->key == key) return slot;
+    }
+    return -1;
+}
+
+std::uint32_t ProfileStore::AcquireSlot(const std::uint64_t key, std::string_view a_character) {
+    if (const auto slot = FindSlot(key); slot >= 0) return static_cast<std::uint32_t>(slot);
+    std::uint32_t claimed = 0;
+    for (std::uint32_t slot = 0; slot < n_profiles; slot++) {
+        const auto* profile = GetProfile(slot);
+        if (!profile->key) {
+            claimed = slot;
+            break;
+        }
+        if (profile->generation < GetProfile(claimed)->generation) claimed = slot;
+    }
+    auto* profile = GetProfile(claimed);
+    if (profile->key) {
+        logger::warn("ProfileStore: All {} profiles taken. Evicting the profile of {}.", n_profiles, profile->name);
+    }
+    profile->key = key;
+    profile->n_rows = 0;
+    const auto name_length = std::min(a_character.size(), sizeof(profile->name) - 1);
+    std::memset(profile->name, 0, sizeof(profile->name));
+    std::memcpy(profile->name, a_character.data(), name_length);
+    return claimed;
+}
+
+std::span<const ProfileStore::Row> ProfileStore::Read(const std::uint64_t a_id) const {
+    if (!IsOpen() || !a_id) return {};
+    const auto slot = FindSlot(a_id);
+    if (slot < 0) return {};
+    const auto* profile = GetProfile(static_cast<std::uint32_t>(slot));
+    if (profile->n_rows > rows_per_profile) {
+        logger::warn("ProfileStore: Profile of {} claims {} rows. Reading the first {}.", profile->name,
+                     profile->n_rows, rows_per_profile);
+    }
+    return {GetRows(static_cast<std::uint32_t>(slot)), std::min(profile->n_rows, rows_per_profile)};
+}
+
+bool ProfileStore::Write(const std::uint64_t a_id, std::string_view a_character, const FavoritesTable& data) {
+    if (!IsOpen()) return false;
+    if (!a_id) {
+        logger::error("ProfileStore: No character id. The profile of {} is not written.", a_character);
+        return false;
+    }
+    const auto slot = AcquireSlot(a_id, a_character);
+    auto* profile = GetProfile(slot);
+    auto* rows = GetRows(slot);
+
+    const auto n_rows = static_cast<std::uint32_t>(std::min<std::size_t>(data.Size(), rows_per_profile));
+    if (n_rows < data.Size()) {
+        logger::warn("ProfileStore: Profile of {} full. Storing {} of {} favorites.", a_character, n_rows,
+                     data.Size());
+    }
+
+    // only rows that differ are written, so unchanged pages stay clean
+    const std::uint8_t* dirty_begin = nullptr;
+    const std::uint8_t* dirty_end = nullptr;
+    for (std::uint32_t i = 0; i < n_rows; i++) {
+        Row row{};
+        row.formid = data.FormIDAt(i);
+        const auto hotkey = data.HotkeyAt(i);
+        row.hotkey = hotkey < 0 ? FavoritesTable::no_hotkey : static_cast<std::uint8_t>(hotkey);
+        if (const auto& editorid = data.EditorIDAt(i); editorid.size() <= editorid_size) {
+            row.editorid_length = static_cast<std::uint8_t>(editorid.size());
+            std::memcpy(row.editorid, editorid.data(), editorid.size());
+        }
+        if (std::memcmp(&rows[i], &row, sizeof(Row)) == 0) continue;
+        rows[i] = row;
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(&rows[i]);
+        if (!dirty_begin) dirty_begin = bytes;
+        dirty_end = bytes + sizeof(Row);
+    }
+
+    auto* header = GetHeader();
+    if (dirty_begin || profile->n_rows != n_rows) {
+        profile->n_rows = n_rows;
+        profile->generation = ++header->generation;
+        Flush(view, view + sizeof(Header) + n_profiles * sizeof(Profile));
+    }
+    if (dirty_begin) Flush(dirty_begin, dirty_end);
+    LOG_TRACE("ProfileStore: Wrote {} favorites for {}, {} bytes dirty.", n_rows, a_character,
+                  dirty_end - dirty_begin);
+    return true;
+}
+
+void ProfileStore::Flush(const std::uint8_t* begin, const std::uint8_t* end) const {
+    constexpr std::size_t page_size = 4096;
+    const auto offset = static_cast<std::size_t>(begin - view) / page_size * page_size;
+    const auto length = static_cast<std::size_t>(end - view) - offset;
+#ifdef _WIN32
+    if (!FlushViewOfFile(view + offset, length)) logger::error("ProfileStore: Flush failed. Error: {}", GetLastError());
+#else
+    if (::msync(view + offset, length, MS_ASYNC) != 0) logger::error("ProfileStore: Flush failed. Error: {}", errno);
+#endif
+}
@@ -0,0 +1,42 @@
+#include "Reconciler.h"
+
+const int HotkeySlots::SlotOf(const FormID formid) const {
+    if (!formid) return -1;
+    for (unsigned int slot = 0; slot < n_slots; slot++) {
+        if (owners[slot] == formid) return slot;
+    }
+    return -1;
+}
+
+void HotkeySlots::Assign(const FormID formid, const unsigned int slot) {
+    if (slot >= n_slots) return;
+    Release(formid);
+    owners[slot] = formid;
+}
+
+void HotkeySlots::Release(const FormID formid) {
+    if (const auto slot = SlotOf(formid); slot >= 0) owners[slot] = 0;
+}
+
+HotkeyPlan SolveHotkeys(std::pmr::vector<std::pair<FormID, unsigned int>> wanted,
+                        const std::array<FormID, HotkeySlots::n_slots>& owners) {
+    HotkeyPlan plan{decltype(HotkeyPlan::writes)(wanted.get_allocator()),
+                    decltype(HotkeyPlan::denied)(wanted.get_allocator())};
+    std::ranges::sort(wanted);
+    const auto [first, last] = std::ranges::unique(wanted, {}, &std::pair<FormID, unsigned int>::first);
+    wanted.erase(first, last);
+
+    std::array<FormID, HotkeySlots::n_slots> taken = owners;
+    // sorted by FormID, so the first form to reach a free slot is the lowest
+    for (const auto& [formid, slot] : wanted) {
+        if (slot >= HotkeySlots::n_slots) continue;
+        if (taken[slot] == formid) continue;
+        if (taken[slot]) {
+            plan.denied.emplace_back(formid, slot);
+            continue;
+        }
+        taken[slot] = formid;
+        plan.writes.emplace_back(formid, slot);
+    }
+    return plan;
+}
@@ -2,104 +2,277 @@
 #include "Serialization.h"
 
 
-void BaseData<SaveDataLHS, SaveDataRHS>::SetData(SaveDataLHS formId, SaveDataRHS value) {
-    Locker locker(m_Lock);
-    m_Data[formId] = value;
+template <>
+void BaseData<FavoritesTable>::Clear() {
+    m_Data.Clear();
 }
 
-
-void BaseData<SaveDataLHS, SaveDataRHS>::Clear() {
-    Locker locker(m_Lock);
-    m_Data.clear();
+void SaveLoadData::DumpToLog() {
+    const auto data = GetSnapshot();
+    logger::info("Favorites: {}", data->Size());
+    Stats::DumpToLog();
 }
 
 [[nodiscard]] bool SaveLoadData::Save(SKSE::SerializationInterface* serializationInterface) {
+    return Save(serializationInterface, Settings::kDataKey, Settings::kSerializationVersion);
+}
+
+[[nodiscard]] bool SaveLoadData::Save(SKSE::SerializationInterface* serializationInterface, std::uint32_t type,
+                        std::uint32_t version) {
     assert(serializationInterface);
-    Locker locker(m_Lock);
+    // the save only ever sees a published snapshot, so it never waits on or races the game thread
+    const auto data = GetSnapshot();
 
-    const auto numRecords = m_Data.size();
-    if (!serializationInterface->WriteRecordData(numRecords)) {
-        logger::error("Failed to save {} data records", numRecords);
-        return false;
-    }
+    const auto rows = SaveableRows(*data);
 
-    for (const auto& [lhs, rhs] : m_Data) {
-        std::uint32_t formid = lhs.first;
-        if (!serializationInterface->WriteRecordData(formid)) {
-            logger::error("Failed to save formid");
+    // an empty table still writes one chunk so the load side sees the record
+    const std::size_t n_chunks = std::max<std::size_t>(1, (rows.size() + Settings::chunk_size - 1) / Settings::chunk_size);
+    Utils::RecordWriter writer;
+    for (std::size_t chunk = 0; chunk < n_chunks; chunk++) {
+        const auto first = chunk * Settings::chunk_size;
+        const auto last = std::min<std::size_t>(rows.size(), first + Settings::chunk_size);
+        if (!serializationInterface->OpenRecord(type, version)) {
+            logger::error("Failed to open record for Data Serialization!");
             return false;
         }
-
-        const std::string editorid = lhs.second;
-        logger::trace("Formid:{:x},Editorid:{}", formid, editorid);
-        Utils::write_string(serializationInterface, editorid);
-
-        if (!serializationInterface->WriteRecordData(rhs)) {
-            logger::error("Failed to save hotkey");
+        writer.Clear();
+        writer.Reserve((last - first) * 28 + 8);
+        writer.WriteVarint(chunk);
+        writer.WriteVarint(n_chunks);
+        WriteRows(writer, *data, rows, first, last);
+        if (!writer.Flush(serializationInterface)) {
+            logger::error("Failed to save chunk {} of {} ({} data records)", chunk + 1, n_chunks, last - first);
             return false;
         }
+        LOG_TRACE("Saved chunk {} of {}: {} data records in {} bytes", chunk + 1, n_chunks, last - first,
+                      writer.Size());
     }
+    LOG_TRACE("Saved {} data records in {} chunks", rows.size(), n_chunks);
     return true;
 }
 
-[[nodiscard]] bool SaveLoadData::Save(SKSE::SerializationInterface* serializationInterface, std::uint32_t type,
-                        std::uint32_t version) {
-    if (!serializationInterface->OpenRecord(type, version)) {
-        logger::error("Failed to open record for Data Serialization!");
-        return false;
+std::vector<std::pair<std::size_t, std::string>> SaveLoadData::SaveableRows(const FavoritesTable& data) {
+    // rows whose form is gone are dropped; missing editor IDs are filled in on the way out
+    const auto form_cache = FormCache::GetSingleton();
+    std::vector<std::pair<std::size_t, std::string>> rows;
+    rows.reserve(data.Size());
+    for (std::size_t row = 0; row < data.Size(); row++) {
+        const auto formid = data.FormIDAt(row);
+        // forms from plugins stay for the session, so the cache answers for them; forms created in the save can be
+        // deleted, so those are still looked up
+        const auto entry = formid >> 24 == 0xFF ? form_cache->Get(Utils::FunctionsSkyrim::GetFormByID(formid))
+                                                : form_cache->Get(formid);
+        if (entry.type == RE::FormType::None) continue;
+        const auto& editorid = data.EditorIDAt(row);
+        rows.emplace_back(row, editorid.empty() ? form_cache->GetEditorID(entry) : std::string());
     }
+    return rows;
+}
 
-    return Save(serializationInterface);
+void SaveLoadData::WriteRows(Utils::RecordWriter& writer, const FavoritesTable& data,
+                             const std::vector<std::pair<std::size_t, std::string>>& rows, const std::size_t first,
+                             const std::size_t last) {
+    writer.WriteVarint(last - first);
+    // deltas restart in every chunk so each record decodes on its own
+    FormID previous_formid = 0;
+    for (std::size_t i = first; i < last; i++) {
+        const auto& [row, filled_editorid] = rows[i];
+        // rows are sorted, so the deltas are small and non-negative
+        const auto formid = data.FormIDAt(row);
+        writer.WriteVarint(formid - previous_formid);
+        previous_formid = formid;
+
+        const auto& editorid = data.EditorIDAt(row).empty() ? filled_editorid : data.EditorIDAt(row);
+        LOG_TRACE("Formid:{:x},Editorid:{}", formid, editorid);
+        writer.WriteString(editorid);
+
+        const auto hotkey = data.HotkeyAt(row);
+        writer.Write(static_cast<std::uint8_t>(hotkey < 0 ? FavoritesTable::no_hotkey : hotkey));
+        writer.WriteVarint(data.InstanceAt(row));
+    }
 }
 
-[[nodiscard]] bool SaveLoadData::Load(SKSE::SerializationInterface* serializationInterface, unsigned int pluginversion) {
+void FormIDRemap::Capture(SKSE::SerializationInterface* serializationInterface) {
+    // ResolveFormID only maps the plugin index, so resolving one FormID per index covers every form of that plugin
+    for (std::uint32_t index = 0; index < full.size(); index++) {
+        FormID resolved;
+        full[index] = serializationInterface->ResolveFormID(index << 24, resolved) ? resolved & 0xFF000000 : unresolved;
+    }
+    for (std::uint32_t index = 0; index < light.size(); index++) {
+        FormID resolved;
+        light[index] = serializationInterface->ResolveFormID(0xFE000000 | index << 12, resolved) ? resolved & 0xFFFFF000
+                                                                                                 : unresolved;
+    }
+    // a saved index whose plugin is gone only keeps its meaning if no other plugin took it since
+    const auto data_handler = RE::TESDataHandler::GetSingleton();
+    identity = true;
+    for (std::uint32_t index = 0; index < full.size() && identity; index++) {
+        identity = full[index] == unresolved ? !data_handler->LookupLoadedModByIndex(static_cast<std::uint8_t>(index))
+                                             : full[index] == index << 24;
+    }
+    for (std::uint32_t index = 0; index < light.size() && identity; index++) {
+        identity = light[index] == unresolved
+                       ? !data_handler->LookupLoadedLightModByIndex(static_cast<std::uint16_t>(index))
+                       : light[index] == (0xFE000000 | index << 12);
+    }
+}
+
+bool FormIDRemap::Resolve(const FormID saved, FormID& resolved) const {
+    const auto index = saved >> 24;
+    if (index < full.size()) {
+        if (full[index] == unresolved) return false;
+        resolved = full[index] | (saved & 0x00FFFFFF);
+        return true;
+    }
+    if (index == 0xFE) {
+        const auto prefix = light[(saved >> 12) & 0xFFF];
+        if (prefix == unresolved) return false;
+        resolved = prefix | (saved & 0xFFF);
+        return true;
+    }
+    // forms created in the save keep their id
+    resolved = saved;
+    return true;
+}
+
+[[nodiscard]] bool SaveLoadData::QueueRecord(SKSE::SerializationInterface* serializationInterface,
+                                             unsigned int pluginversion, std::uint32_t length) {
     assert(serializationInterface);
+    std::vector<std::uint8_t> bytes(length);
+    if (length && serializationInterface->ReadRecordData(bytes.data(), length) != length) {
+        logger::error("Failed to read record of {} bytes", length);
+        return false;
+    }
+    queued_records.push_back({pluginversion, std::move(bytes)});
+    return true;
+}
+
+void SaveLoadData::StartDecode(SKSE::SerializationInterface* serializationInterface) {
+    if (queued_records.empty()) return;
+    auto remap = std::make_unique<FormIDRemap>();
+    remap->Capture(serializationInterface);
+    decoding = std::async(std::launch::async, [records = std::exchange(queued_records, {}), remap = std::move(remap)]() {
+        Stats::ScopedTimer timer(Stats::Probe::kDecode);
+        std::vector<SavedRow> rows;
+        const Resolver resolve = [&remap](FormID& formid) { return remap->Resolve(formid, formid); };
+        for (const auto& [plugin_version, bytes] : records) {
+            Utils::RecordReader reader(bytes);
+            if (!Decode(reader, plugin_version, resolve, rows)) logger::critical("Failed to decode record");
+        }
+        timer.SetItems(rows.size());
+        return rows;
+    });
+}
 
+bool SaveLoadData::FinishDecode() {
+    if (!decoding.valid()) return false;
+    const auto rows = decoding.get();
+    InsertRows(m_Data, rows);
+    logger::info("Decoded {} data records.", rows.size());
+    return true;
+}
+
+void SaveLoadData::DiscardDecode() {
+    queued_records.clear();
+    if (decoding.valid()) decoding.wait();
+    decoding = {};
+}
+
+std::size_t SaveLoadData::InsertRows(FavoritesTable& data, const std::vector<SavedRow>& rows) {
+    std::vector<FavoritesTable::Row> batch;
+    batch.reserve(rows.size());
+    for (const auto& [formid, hotkey, editorid, instance] : rows) batch.push_back({formid, hotkey, editorid, instance});
+    const auto n_inserted = data.InsertRows(batch);
+    if (n_inserted < rows.size()) logger::warn("Dropped {} duplicate records", rows.size() - n_inserted);
+    return n_inserted;
+}
+
+[[nodiscard]] bool SaveLoadData::Decode(Utils::RecordReader& reader, unsigned int pluginversion,
+                                        const Resolver& resolve, std::vector<SavedRow>& rows) {
     if (pluginversion < 1) {
 		logger::error("Plugin version is less than 0.1, skipping load.");
 		return false;
 	}
+    if (!reader) return false;
 
+    LOG_TRACE("Decoding data record.");
+    if (pluginversion < 3) return DecodeLegacy(reader, pluginversion, resolve, rows);
+    return DecodeChunk(reader, resolve, rows);
+}
+
+[[nodiscard]] bool SaveLoadData::DecodeLegacy(Utils::RecordReader& reader, unsigned int pluginversion,
+                                              const Resolver& resolve, std::vector<SavedRow>& rows) {
     std::size_t recordDataSize;
-    serializationInterface->ReadRecordData(recordDataSize);
+    if (!reader.Read(recordDataSize)) {
+        logger::error("Failed to read number of records");
+        return false;
+    }
     logger::info("Loading data from serialization interface with size: {}", recordDataSize);
 
-    Locker locker(m_Lock);
-    m_Data.clear();
-
-    logger::trace("Loading data from serialization interface.");
-    for (auto i = 0; i < recordDataSize; i++) {
+    for (std::size_t i = 0; i < recordDataSize; i++) {
         std::uint32_t formid = 0;
-        logger::trace("ReadRecordData:{}", serializationInterface->ReadRecordData(formid));
-        if (!serializationInterface->ResolveFormID(formid, formid)) {
+        std::string editorid;
+        SaveDataRHS rhs = -1;
+        if (!reader.Read(formid) || !reader.ReadLegacyString(editorid) ||
+            (pluginversion >= 2 && !reader.Read(rhs))) {
+            logger::error("Failed to read record {} of {}", i, recordDataSize);
+            return false;
+        }
+        if (!resolve(formid)) {
             logger::error("Failed to resolve form ID, 0x{:X}.", formid);
             continue;
         }
+        LOG_TRACE("Loaded data for formid {}, editorid {}", formid, editorid);
+        rows.push_back({formid, rhs, std::move(editorid), FavoritesTable::any_instance});
+    }
 
-        std::string editorid;
-        if (!Utils::read_string(serializationInterface, editorid)) {
-            logger::error("Failed to read editorid");
+    return true;
+}
+
+[[nodiscard]] bool SaveLoadData::DecodeChunk(Utils::RecordReader& reader, const Resolver& resolve,
+                                             std::vector<SavedRow>& rows) {
+    std::uint64_t chunk;
+    std::uint64_t n_chunks;
+    if (!reader.ReadVarint(chunk) || !reader.ReadVarint(n_chunks) || chunk >= n_chunks) {
+        logger::error("Failed to read chunk header");
+        return false;
+    }
+    LOG_TRACE("Loading chunk {} of {}", chunk + 1, n_chunks);
+    return DecodeRows(reader, resolve, rows);
+}
+
+[[nodiscard]] bool SaveLoadData::DecodeRows(Utils::RecordReader& reader, const Resolver& resolve,
+                                            std::vector<SavedRow>& rows) {
+    std::uint64_t recordDataSize;
+    if (!reader.ReadVarint(recordDataSize)) {
+        logger::error("Failed to read number of records");
+        return false;
+    }
+    logger::info("Loading data from serialization interface with size: {}", recordDataSize);
+    rows.reserve(rows.size() + std::min<std::uint64_t>(recordDataSize, reader.Remaining()));
+
+    std::uint64_t saved_formid = 0;
+    std::string editorid;
+    for (std::uint64_t i = 0; i < recordDataSize; i++) {
+        std::uint64_t delta;
+        std::uint8_t hotkey;
+        std::uint64_t instance;
+        if (!reader.ReadVarint(delta) || !reader.ReadString(editorid) || !reader.Read(hotkey) ||
+            !reader.ReadVarint(instance)) {
+            logger::error("Failed to read record {} of {}", i, recordDataSize);
             return false;
         }
-
-        SaveDataLHS lhs({formid, editorid});
-        logger::trace("Reading value...");
-
-        if (pluginversion < 2) {
-            m_Data[lhs] = -1;
-        } 
-        else {
-			SaveDataRHS rhs;
-            if (!serializationInterface->ReadRecordData(rhs)) {
-				logger::error("Failed to read hotkey");
-				return false;
-			}
-			m_Data[lhs] = rhs;
+        saved_formid += delta;
+        FormID formid = static_cast<FormID>(saved_formid);
+        if (!resolve(formid)) {
+            logger::error("Failed to resolve form ID, 0x{:X}.", saved_formid);
+            continue;
         }
-
-        logger::info("Loaded data for formid {}, editorid {}", formid, editorid);
+        LOG_TRACE("Loaded data for formid {}, editorid {}", formid, editorid);
+        // out of range hotkeys are dropped here rather than on the game thread
+        const int valid_hotkey = hotkey < 8 ? hotkey : -1;
+        rows.push_back({formid, valid_hotkey, editorid, static_cast<std::uint32_t>(instance)});
     }
 
     return true;
 }
-
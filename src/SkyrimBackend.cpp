@@ -0,0 +1,41 @@
+#include "SkyrimBackend.h"
+
+std::size_t SkyrimBackend::FavoriteItems(std::span<const Instance> instances) {
+    return Utils::FunctionsSkyrim::Inventory::FavoriteItems(instances, RE::PlayerCharacter::GetSingleton());
+}
+
+void SkyrimBackend::FavoriteSpell(const FormID formid) {
+    if (const auto spell = Utils::FunctionsSkyrim::GetFormByID(formid)) {
+        RE::MagicFavorites::GetSingleton()->SetFavorite(spell);
+    }
+}
+
+const std::unordered_set<FormID>& SkyrimBackend::GetPlayerSpells() {
+    if (spell_cache && player_spells_valid) return player_spells;
+    player_spells.clear();
+    player_spells_valid = true;
+    RE::PlayerCharacter::GetSingleton()->VisitSpells(*this);
+    return player_spells;
+}
+
+void SkyrimBackend::MirrorFavoritedSpells() {
+    favorited_spells.clear();
+    for (const auto& spell : RE::MagicFavorites::GetSingleton()->spells) {
+        if (spell) favorited_spells.insert(spell->GetFormID());
+    }
+}
+
+int SkyrimBackend::GetHotkey(const RE::ExtraDataList* xList) {
+    if (!xList) return -1;
+    const auto xHotkey = xList->GetByType<RE::ExtraHotkey>();
+    if (!xHotkey) return -1;
+    const int hotkey = xHotkey->hotkey.underlying();
+    return hotkey >= 0 && hotkey < static_cast<int>(HotkeySlots::n_slots) ? hotkey : -1;
+}
+
+RE::BSContainer::ForEachResult SkyrimBackend::Visit(RE::SpellItem* a_spell) {
+    if (!a_spell) return RE::BSContainer::ForEachResult::kContinue;
+    if (!form_cache->HasName(a_spell)) return RE::BSContainer::ForEachResult::kContinue;
+    player_spells.insert(a_spell->GetFormID());
+    return RE::BSContainer::ForEachResult::kContinue;
+}
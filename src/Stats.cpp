@@ -0,0 +1,88 @@
+#include "Stats.h"
+
+namespace Stats {
+
+    namespace {
+        std::array<Histogram, static_cast<std::size_t>(Probe::kTotal)> histograms;
+
+        constexpr std::array<std::string_view, static_cast<std::size_t>(Probe::kTotal)> probe_names = {
+            "Input", "Menu", "ContainerChanged", "SpellsLearned", "Drain", "AddFavorites", "SyncFavorites",
+            "SyncHotkeys", "Restore", "Save", "Load", "Decode"};
+    };
+
+    unsigned int Histogram::BucketOf(const std::uint64_t us) {
+        if (us < n_sub) return static_cast<unsigned int>(us);
+        const auto msb = static_cast<unsigned int>(std::bit_width(us)) - 1;
+        const auto octave = msb - sub_bits + 1;
+        if (octave >= n_octaves) return n_buckets - 1;
+        const auto sub = static_cast<unsigned int>(us >> (msb - sub_bits)) & (n_sub - 1);
+        return octave * n_sub + sub;
+    }
+
+    std::uint64_t Histogram::LowerBound(const unsigned int bucket) {
+        const auto octave = bucket / n_sub;
+        const auto sub = bucket % n_sub;
+        if (!octave) return sub;
+        return std::uint64_t{n_sub + sub} << (octave - 1);
+    }
+
+    void Histogram::Record(const std::uint64_t us, const std::uint64_t n_items) {
+        buckets[BucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        items.fetch_add(n_items, std::memory_order_relaxed);
+        auto current = max_us.load(std::memory_order_relaxed);
+        while (us > current && !max_us.compare_exchange_weak(current, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Histogram::Reset() {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        max_us.store(0, std::memory_order_relaxed);
+        items.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Histogram::Percentile(const double p) const {
+        const auto n = Count();
+        if (!n) return 0;
+        const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p * n)));
+        std::uint64_t seen = 0;
+        for (unsigned int bucket = 0; bucket < n_buckets; bucket++) {
+            seen += buckets[bucket].load(std::memory_order_relaxed);
+            if (seen < target) continue;
+            if (bucket + 1 == n_buckets) return Max();
+            return std::min(LowerBound(bucket + 1) - 1, Max());
+        }
+        return Max();
+    }
+
+    Histogram& Get(const Probe probe) { return histograms[static_cast<std::size_t>(probe)]; }
+
+    ScopedTimer::~ScopedTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        Get(probe).Record(static_cast<std::uint64_t>(us), n_items);
+    }
+
+    std::string Summary() {
+        std::string summary;
+        for (std::size_t i = 0; i < histograms.size(); i++) {
+            const auto& histogram = histograms[i];
+            if (!histogram.Count()) continue;
+            summary += std::format("{}: n={} p50={}us p99={}us max={}us items={}\n", probe_names[i],
+                                   histogram.Count(), histogram.Percentile(0.5), histogram.Percentile(0.99),
+                                   histogram.Max(), histogram.Items());
+        }
+        return summary.empty() ? "No samples yet.\n" : summary;
+    }
+
+    void DumpToLog() {
+        logger::info("--------Stats---------");
+        std::istringstream lines(Summary());
+        for (std::string line; std::getline(lines, line);) logger::info("{}", line);
+    }
+
+    void Reset() {
+        for (auto& histogram : histograms) histogram.Reset();
+    }
+};
@@ -1,5 +1,6 @@
 
 #include "Utils.h"
+#include "FormCache.h"
 
 namespace Utils {
 
@@ -105,9 +106,7 @@ namespace Utils {
         };
 
         const std::string GetEditorID(const FormID a_formid) {
-            if (const auto form = RE::TESForm::LookupByID(a_formid)) {
-                return clib_util::editorID::get_editorID(form);
-            } else return "";
+            return FormCache::GetSingleton()->GetEditorID(a_formid);
         }
 
         namespace Menu {
@@ -135,10 +134,170 @@ namespace Utils {
                     queue->AddMessage(menuName, RE::UI_MESSAGE_TYPE::kHide, nullptr);
                 }
             };
+
+            const RefID GetContainerMenuTarget() {
+                const auto target = RE::TESObjectREFR::LookupByHandle(RE::ContainerMenu::GetTargetRefHandle());
+                return target ? target->GetFormID() : 0;
+            };
         };
 
         namespace Inventory {
 
+            static RE::TESObjectREFR* snapshot_owner = nullptr;
+            static Snapshot snapshot;
+            static std::uint32_t snapshot_epoch = 0;
+
+            Snapshot GetSnapshot(RE::TESObjectREFR* inventory_owner) {
+                if (!inventory_owner) return std::make_shared<const RE::TESObjectREFR::InventoryItemMap>();
+                if (!snapshot || snapshot_owner != inventory_owner) {
+                    snapshot = std::make_shared<const RE::TESObjectREFR::InventoryItemMap>(inventory_owner->GetInventory());
+                    snapshot_owner = inventory_owner;
+                    LOG_TRACE("Inventory snapshot built. Epoch: {}, Entries: {}", snapshot_epoch, snapshot->size());
+                }
+                return snapshot;
+            }
+
+            void InvalidateSnapshot() {
+                snapshot.reset();
+                snapshot_owner = nullptr;
+                snapshot_epoch++;
+            }
+
+            const std::uint32_t GetSnapshotEpoch() { return snapshot_epoch; }
+
+            static unsigned int scope_depth = 0;
+
+            void EnterSnapshotScope() {
+                InvalidateSnapshot();
+                scope_depth++;
+            }
+
+            void LeaveSnapshotScope() {
+                InvalidateSnapshot();
+                scope_depth--;
+            }
+
+            struct IndexCache {
+                RE::TESObjectREFR* owner = nullptr;
+                std::uint32_t epoch = 0;
+                EntryIndex entries;
+                std::unordered_map<std::uint64_t, RE::ExtraDataList*> instances;
+            };
+            // Both hold raw entry pointers, which the game frees without telling anyone (crafting, tempering, scripted
+            // RemoveItem, rebuilds of the changes list), so neither outlives the snapshot epoch it was built in.
+            static IndexCache player_index;
+            static IndexCache other_index;
+            static std::atomic_bool entries_changed = true;
+
+            static inline std::uint64_t InstanceKey(const FormID formid, const std::uint32_t fingerprint) {
+                return std::uint64_t{formid} << 32 | fingerprint;
+            }
+
+            static void BuildIndex(IndexCache& cache, RE::TESObjectREFR* inventory_owner) {
+                cache.entries.clear();
+                cache.instances.clear();
+                cache.owner = inventory_owner;
+                cache.epoch = snapshot_epoch;
+                if (!inventory_owner) return;
+                const auto inventory_changes = inventory_owner->GetInventoryChanges();
+                if (!inventory_changes || !inventory_changes->entryList) return;
+                for (auto* entry : *inventory_changes->entryList) {
+                    if (!entry || !entry->object) continue;
+                    const auto formid = entry->object->GetFormID();
+                    cache.entries.emplace(formid, entry);
+                    if (!entry->extraLists) continue;
+                    for (auto* xList : *entry->extraLists) {
+                        // the first of several plain lists stands in for all of them
+                        if (xList) cache.instances.emplace(InstanceKey(formid, GetInstanceFingerprint(xList)), xList);
+                    }
+                }
+                LOG_TRACE("Entry index built. Epoch: {}, Entries: {}, Instances: {}", cache.epoch, cache.entries.size(),
+                          cache.instances.size());
+            }
+
+            static IndexCache& GetIndexCache(RE::TESObjectREFR* inventory_owner) {
+                const bool is_player =
+                    inventory_owner && inventory_owner == RE::PlayerCharacter::GetSingleton()->AsReference();
+                auto& cache = is_player ? player_index : other_index;
+                const auto changed = entries_changed.exchange(false, std::memory_order_acquire);
+                // outside a SnapshotScope the epoch may span frames, so nothing built there is trusted twice
+                if (changed || !scope_depth || cache.owner != inventory_owner || cache.epoch != snapshot_epoch) {
+                    BuildIndex(cache, inventory_owner);
+                }
+                if (changed) {
+                    auto& other = is_player ? other_index : player_index;
+                    other.owner = nullptr;
+                }
+                return cache;
+            }
+
+            const EntryIndex& GetEntryIndex(RE::TESObjectREFR* inventory_owner) {
+                return GetIndexCache(inventory_owner).entries;
+            }
+
+            void InvalidateEntryIndex() { entries_changed.store(true, std::memory_order_release); }
+
+            RE::InventoryEntryData* FindEntry(const FormID formid, RE::TESObjectREFR* inventory_owner) {
+                const auto& index = GetEntryIndex(inventory_owner);
+                const auto it = index.find(formid);
+                return it == index.end() ? nullptr : it->second;
+            }
+
+            std::uint32_t GetInstanceFingerprint(const RE::ExtraDataList* xList) {
+                if (!xList) return 0;
+                // FNV-1a over the fields that tell otherwise identical stacks apart
+                std::uint32_t hash = 2166136261u;
+                bool has_identity = false;
+                const auto mix = [&hash, &has_identity](const std::uint32_t value) {
+                    has_identity = true;
+                    for (unsigned int shift = 0; shift < 32; shift += 8) {
+                        hash ^= (value >> shift) & 0xFF;
+                        hash *= 16777619u;
+                    }
+                };
+                if (const auto xEnchantment = xList->GetByType<RE::ExtraEnchantment>();
+                    xEnchantment && xEnchantment->enchantment) {
+                    mix(xEnchantment->enchantment->GetFormID());
+                }
+                if (const auto xHealth = xList->GetByType<RE::ExtraHealth>()) {
+                    mix(std::bit_cast<std::uint32_t>(xHealth->health));
+                }
+                if (const auto xUniqueID = xList->GetByType<RE::ExtraUniqueID>()) {
+                    mix(xUniqueID->baseID);
+                    mix(xUniqueID->uniqueID);
+                }
+                if (!has_identity) return 0;
+                return hash ? hash : 1;
+            }
+
+            RE::ExtraDataList* GetFavoritedList(const RE::InventoryEntryData* a_entry) {
+                if (!a_entry || !a_entry->extraLists) return nullptr;
+                for (auto* xList : *a_entry->extraLists) {
+                    if (xList && xList->HasType(RE::ExtraDataType::kHotkey)) return xList;
+                }
+                return nullptr;
+            }
+
+            RE::ExtraDataList* FindInstance(const FormID formid, const std::uint32_t fingerprint,
+                                            RE::TESObjectREFR* inventory_owner) {
+                auto& cache = GetIndexCache(inventory_owner);
+                const auto entry = cache.entries.find(formid);
+                if (entry == cache.entries.end() || !entry->second->extraLists) return nullptr;
+                const auto& xLists = *entry->second->extraLists;
+                const auto key = InstanceKey(formid, fingerprint);
+                // the cached list is only dereferenced once the entry is known to still hold it
+                if (const auto it = cache.instances.find(key); it != cache.instances.end()) {
+                    for (auto* xList : xLists) {
+                        if (xList == it->second && GetInstanceFingerprint(xList) == fingerprint) return xList;
+                    }
+                }
+                for (auto* xList : xLists) {
+                    if (xList && GetInstanceFingerprint(xList) == fingerprint) return cache.instances[key] = xList;
+                }
+                cache.instances.erase(key);
+                return nullptr;
+            }
+
             const bool HasItemEntry(RE::TESBoundObject* item, RE::TESObjectREFR* inventory_owner,
                                     bool nonzero_entry_check) {
                 if (!item) {
@@ -149,9 +308,11 @@ namespace Utils {
                     logger::warn("Inventory owner is null");
                     return 0;
                 }
-                auto inventory = inventory_owner->GetInventory();
-                auto it = inventory.find(item);
-                bool has_entry = it != inventory.end();
+                // counts need the base container, so only the plain entry test can skip the snapshot
+                if (!nonzero_entry_check && FindEntry(item->GetFormID(), inventory_owner)) return true;
+                const auto inventory = GetSnapshot(inventory_owner);
+                const auto it = inventory->find(item);
+                bool has_entry = it != inventory->end();
                 if (nonzero_entry_check) return has_entry && it->second.first > 0;
                 return has_entry;
             }
@@ -163,59 +324,62 @@ namespace Utils {
 
             void FavoriteItem(RE::TESBoundObject* item, RE::TESObjectREFR* inventory_owner) {
                 if (!item) return;
-                if (!inventory_owner) return;
+                const Instance instance{item->GetFormID()};
+                FavoriteItems({&instance, 1}, inventory_owner);
+            }
+
+            void FavoriteItem(const FormID formid, const FormID refid) {
+                const Instance instance{formid};
+                FavoriteItems({&instance, 1}, GetFormByID<RE::TESObjectREFR>(refid));
+            }
+
+            std::size_t FavoriteItems(std::span<const Instance> instances, RE::TESObjectREFR* inventory_owner) {
+                if (instances.empty()) return 0;
+                if (!inventory_owner) return 0;
                 auto inventory_changes = inventory_owner->GetInventoryChanges();
                 if (!inventory_changes) {
-					logger::error("Inventory changes is null");
-					return;
-				}
-                auto entries = inventory_changes->entryList;
-                for (auto it = entries->begin(); it != entries->end(); ++it) {
-                    if (!(*it)) {
-                        logger::error("Item entry is null");
-                        continue;
-                    }
-                    const auto object = (*it)->object;
-                    if (!object) {
-                        logger::error("Object is null");
+                    logger::error("Inventory changes is null");
+                    return 0;
+                }
+                std::size_t n_favorited = 0;
+                std::size_t n_fallbacks = 0;
+                for (const auto& [formid, fingerprint] : instances) {
+                    auto* entry = FindEntry(formid, inventory_owner);
+                    if (!entry) {
+                        logger::error("Item not found in inventory. FormID: {:x}", formid);
                         continue;
                     }
-                    auto formid = object->GetFormID();
-                    if (!formid) logger::critical("Formid is null");
-                    if (formid == item->GetFormID()) {
-                        logger::trace("Favoriting item: {}", item->GetName());
-                        const auto xLists = (*it)->extraLists;
-                        bool no_extra_ = false;
-                        if (!xLists || xLists->empty()) {
-                            logger::trace("No extraLists");
-                            no_extra_ = true;
-                        }
-                        logger::trace("asdasd");
-                        if (no_extra_) {
-                            logger::trace("No extraLists");
-                             inventory_changes->SetFavorite((*it), nullptr);
-                        } else if (xLists->front()) {
-                            logger::trace("ExtraLists found");
-                            inventory_changes->SetFavorite((*it), xLists->front());
-                        }
-                        return;
-                    }
+                    LOG_TRACE("Favoriting item: {}, instance: {:x}", entry->object->GetName(), fingerprint);
+                    const auto xLists = entry->extraLists;
+                    if (auto* xList = FindInstance(formid, fingerprint, inventory_owner)) {
+                        inventory_changes->SetFavorite(entry, xList);
+                    } else if (!xLists || xLists->empty()) {
+                        inventory_changes->SetFavorite(entry, nullptr);
+                    } else if (xLists->front()) {
+                        LOG_TRACE("Instance {:x} not found. FormID: {:x}", fingerprint, formid);
+                        inventory_changes->SetFavorite(entry, xLists->front());
+                        if (fingerprint) n_fallbacks++;
+                    } else continue;
+                    n_favorited++;
                 }
-                logger::error("Item not found in inventory");
-            }
-
-            void FavoriteItem(const FormID formid, const FormID refid) {
-                FavoriteItem(GetFormByID<RE::TESBoundObject>(formid), GetFormByID<RE::TESObjectREFR>(refid));
+                if (n_fallbacks) {
+                    logger::info("{} favorited items no longer had their saved stack and went on another one.",
+                                 n_fallbacks);
+                }
+                if (n_favorited) InvalidateSnapshot();
+                return n_favorited;
             }
 
             [[nodiscard]] const bool HasItemPlusCleanUp(RE::TESBoundObject* item, RE::TESObjectREFR* item_owner,
                                                         RE::ExtraDataList* xList) {
-                logger::trace("HasItemPlusCleanUp");
+                LOG_TRACE("HasItemPlusCleanUp");
 
                 if (HasItem(item, item_owner)) return true;
                 if (HasItemEntry(item, item_owner)) {
                     item_owner->RemoveItem(item, 1, RE::ITEM_REMOVE_REASON::kRemove, xList, nullptr);
-                    logger::trace("Item with zero count removed from player.");
+                    InvalidateSnapshot();
+                    InvalidateEntryIndex();
+                    LOG_TRACE("Item with zero count removed from player.");
                 }
                 return false;
             }
@@ -229,13 +393,9 @@ namespace Utils {
                     logger::warn("Inventory owner is null");
                     return false;
                 }
-                auto inventory = inventory_owner->GetInventory();
-                auto it = inventory.find(item);
-                if (it != inventory.end()) {
-                    if (it->second.first <= 0) logger::warn("Item count is 0");
-                    return it->second.second->IsFavorited();
-                }
-                return false;
+                // favoriting always creates an entry in the changes list
+                const auto entry = FindEntry(item->GetFormID(), inventory_owner);
+                return entry && entry->IsFavorited();
             }
 
             [[nodiscard]] const bool IsFavorited(RE::FormID formid, RE::FormID refid) {
@@ -249,38 +409,84 @@ namespace Utils {
 
     };
 
-    bool read_string(SKSE::SerializationInterface* a_intfc, std::string& a_str) {
-        std::vector<std::pair<int, bool>> encodedStr;
-        std::size_t size;
-        if (!a_intfc->ReadRecordData(size)) {
+    void RecordWriter::WriteBytes(const void* a_data, const std::size_t a_size) {
+        const auto* bytes = static_cast<const std::uint8_t*>(a_data);
+        buffer.insert(buffer.end(), bytes, bytes + a_size);
+    }
+
+    void RecordWriter::WriteVarint(std::uint64_t a_value) {
+        while (a_value >= 0x80) {
+            buffer.push_back(static_cast<std::uint8_t>(a_value | 0x80));
+            a_value >>= 7;
+        }
+        buffer.push_back(static_cast<std::uint8_t>(a_value));
+    }
+
+    void RecordWriter::WriteString(const std::string_view a_str) {
+        WriteVarint(a_str.size());
+        WriteBytes(a_str.data(), a_str.size());
+    }
+
+    bool RecordWriter::Flush(SKSE::SerializationInterface* a_intfc) const {
+        if (buffer.size() > std::numeric_limits<std::uint32_t>::max()) {
+            logger::error("Record too large: {} bytes", buffer.size());
             return false;
         }
-        for (std::size_t i = 0; i < size; i++) {
-            std::pair<int, bool> temp_pair;
-            if (!a_intfc->ReadRecordData(temp_pair)) {
-                return false;
-            }
-            encodedStr.push_back(temp_pair);
+        return a_intfc->WriteRecordData(buffer.data(), static_cast<std::uint32_t>(buffer.size()));
+    }
+
+    RecordReader::RecordReader(SKSE::SerializationInterface* a_intfc, const std::uint32_t a_length)
+        : buffer(a_length) {
+        if (a_length && a_intfc->ReadRecordData(buffer.data(), a_length) != a_length) {
+            logger::error("Failed to read record of {} bytes", a_length);
+            ok = false;
         }
-        a_str = Utils::Functions::String::decodeString(encodedStr);
+    }
+
+    bool RecordReader::ReadBytes(void* a_data, const std::size_t a_size) {
+        if (Remaining() < a_size) return ok = false;
+        std::memcpy(a_data, buffer.data() + pos, a_size);
+        pos += a_size;
         return true;
     }
 
-    bool write_string(SKSE::SerializationInterface* a_intfc, const std::string& a_str) {
-        const auto encodedStr = Utils::Functions::String::encodeString(a_str);
-        // i first need the size to know no of iterations
-        const auto size = encodedStr.size();
-        if (!a_intfc->WriteRecordData(size)) {
-            return false;
+    bool RecordReader::ReadVarint(std::uint64_t& a_value) {
+        a_value = 0;
+        for (unsigned int shift = 0; shift < 64; shift += 7) {
+            if (!Remaining()) return ok = false;
+            const auto byte = buffer[pos++];
+            a_value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
         }
-        for (const auto& temp_pair : encodedStr) {
-            if (!a_intfc->WriteRecordData(temp_pair)) {
-                return false;
-            }
+        return ok = false;
+    }
+
+    bool RecordReader::ReadString(std::string& a_str) {
+        std::uint64_t size;
+        if (!ReadVarint(size) || Remaining() < size) return ok = false;
+        a_str.assign(reinterpret_cast<const char*>(buffer.data() + pos), size);
+        pos += size;
+        return true;
+    }
+
+    bool RecordReader::ReadLegacyString(std::string& a_str) {
+        std::size_t size;
+        if (!Read(size) || Remaining() / sizeof(std::pair<int, bool>) < size) return ok = false;
+        // same layout as std::pair<int, bool>, which is not trivially copyable
+        struct LegacyChar {
+            int ch;
+            bool upper;
+        };
+        static_assert(sizeof(LegacyChar) == sizeof(std::pair<int, bool>));
+        legacy_scratch.resize(size);
+        for (auto& temp_pair : legacy_scratch) {
+            LegacyChar legacy_char;
+            if (!Read(legacy_char)) return false;
+            temp_pair = {legacy_char.ch, legacy_char.upper};
         }
+        a_str = Utils::Functions::String::decodeString(legacy_scratch);
         return true;
     }
 
-    
 };
 
@@ -1,5 +1,7 @@
 
 #include "Events.h"
+#include "Hooks.h"
+#include "Papyrus.h"
 
 auto* eventSink = myEventSink::GetSingleton();
 bool eventsinks_added = false;
@@ -12,6 +14,18 @@ void OnMessage(SKSE::MessagingInterface::Message* message) {
             Utils::MsgBoxesNotifs::Windows::Po3ErrMsg();
             return;
         }
+        if (Settings::use_profile_store && !ProfileStore::GetSingleton()->Open(Settings::profile_store_path)) {
+            logger::warn("Profile store not available. Favorites will only be kept in the cosave.");
+        }
+    }
+    if (message->type == SKSE::MessagingInterface::kPostLoadGame) {
+        // resolve the favorites staged by the load callback over the next frames
+        Manager::GetSingleton()->ScheduleRestore();
+    }
+    if (message->type == SKSE::MessagingInterface::kNewGame) {
+        // a new character has a new inventory and profile, and no load callback resets the entry index or the id
+        Utils::FunctionsSkyrim::Inventory::InvalidateEntryIndex();
+        Manager::GetSingleton()->ResetProfileID();
     }
     if (message->type == SKSE::MessagingInterface::kNewGame || message->type == SKSE::MessagingInterface::kPostLoadGame) {
         // Post-load
@@ -27,21 +41,52 @@ void OnMessage(SKSE::MessagingInterface::Message* message) {
     }
 }
 
+namespace {
+    // Records below warn go through a bounded queue to one worker thread, which drops the oldest of them when the queue
+    // is full. Warnings and errors skip the queue and are written on the calling thread, so none of them are lost;
+    // they may land in the file ahead of info records still queued.
+    class SplitSink final : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+    public:
+        SplitSink(std::shared_ptr<spdlog::sinks::sink> a_file, std::shared_ptr<spdlog::async_logger> a_queue)
+            : file(std::move(a_file)), queue(std::move(a_queue)) {}
+
+    protected:
+        void sink_it_(const spdlog::details::log_msg& a_msg) override {
+            if (a_msg.level >= spdlog::level::warn) file->log(a_msg);
+            else queue->log(a_msg.time, a_msg.source, a_msg.level, a_msg.payload);
+        }
+
+        void flush_() override {
+            queue->flush();
+            file->flush();
+        }
+
+    private:
+        std::shared_ptr<spdlog::sinks::sink> file;
+        std::shared_ptr<spdlog::async_logger> queue;
+    };
+}
+
 static void SetupLog() {
     auto logsFolder = SKSE::log::log_directory();
     if (!logsFolder) SKSE::stl::report_and_fail("SKSE log_directory not provided, logs disabled.");
     auto pluginName = SKSE::PluginDeclaration::GetSingleton()->GetName();
     auto logFilePath = *logsFolder / std::format("{}.log", pluginName);
     auto fileLoggerPtr = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath.string(), true);
-    auto loggerPtr = std::make_shared<spdlog::logger>("log", std::move(fileLoggerPtr));
+    spdlog::init_thread_pool(8192, 1);
+    auto queuePtr = std::make_shared<spdlog::async_logger>("log_queue", fileLoggerPtr, spdlog::thread_pool(),
+                                                           spdlog::async_overflow_policy::overrun_oldest);
+    queuePtr->set_level(spdlog::level::trace);
+    auto loggerPtr = std::make_shared<spdlog::logger>(
+        "log", std::make_shared<SplitSink>(std::move(fileLoggerPtr), std::move(queuePtr)));
     spdlog::set_default_logger(std::move(loggerPtr));
 #ifndef NDEBUG
     spdlog::set_level(spdlog::level::trace);
-    spdlog::flush_on(spdlog::level::trace);
 #else
     spdlog::set_level(spdlog::level::info);
-    spdlog::flush_on(spdlog::level::info);
 #endif
+    spdlog::flush_on(spdlog::level::warn);
+    spdlog::flush_every(std::chrono::seconds(3));
     logger::info("Name of the plugin is {}.", pluginName);
     logger::info("Version of the plugin is {}.", SKSE::PluginDeclaration::GetSingleton()->GetVersion());
 }
@@ -60,7 +105,7 @@ void InitializeSerialization() {
     serialization->SetUniqueID(Settings::kDataKey);
     serialization->SetSaveCallback(SaveCallback);
     serialization->SetLoadCallback(LoadCallback);
-    SKSE::log::trace("Cosave serialization initialized.");
+    LOG_TRACE("Cosave serialization initialized.");
 }
 
 SKSEPluginLoad(const SKSE::LoadInterface *skse) {
@@ -69,6 +114,8 @@ SKSEPluginLoad(const SKSE::LoadInterface *skse) {
     logger::info("Plugin loaded");
     SKSE::Init(skse);
     InitializeSerialization();
+    Hooks::Install();
+    SKSE::GetPapyrusInterface()->Register(Papyrus::Register);
     SKSE::GetMessagingInterface()->RegisterListener(OnMessage);
     return true;
 }
\ No newline at end of file